@@ -0,0 +1,483 @@
+/**
+ * @file elvas_bench.cpp
+ * @brief Benchmarks of ELVAS
+ * @date Created on: 2026/10/17, 17:50
+ */
+
+#include "../src/include/elvas_script.h"
+#include "synthetic_data.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <boost/program_options.hpp>
+
+static std::atomic<size_t> nAllocs(0);
+
+// Every form of operator new counts, so that allocs_per_unit is complete.
+// The aligned forms are matched by the aligned deletes, which free what
+// aligned_alloc returned.
+
+static void* allocate(size_t arg_size) {
+    nAllocs++;
+    if (void* ptr = std::malloc(arg_size ? arg_size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t arg_size) {
+    return allocate(arg_size);
+}
+
+void* operator new[](size_t arg_size) {
+    return allocate(arg_size);
+}
+
+void* operator new(size_t arg_size, const std::nothrow_t&) noexcept {
+    nAllocs++;
+    return std::malloc(arg_size ? arg_size : 1);
+}
+
+void* operator new[](size_t arg_size, const std::nothrow_t&) noexcept {
+    nAllocs++;
+    return std::malloc(arg_size ? arg_size : 1);
+}
+
+void operator delete(void* arg_ptr) noexcept {
+    std::free(arg_ptr);
+}
+
+void operator delete[](void* arg_ptr) noexcept {
+    std::free(arg_ptr);
+}
+
+void operator delete(void* arg_ptr, size_t) noexcept {
+    std::free(arg_ptr);
+}
+
+void operator delete[](void* arg_ptr, size_t) noexcept {
+    std::free(arg_ptr);
+}
+
+void operator delete(void* arg_ptr, const std::nothrow_t&) noexcept {
+    std::free(arg_ptr);
+}
+
+void operator delete[](void* arg_ptr, const std::nothrow_t&) noexcept {
+    std::free(arg_ptr);
+}
+
+#if __cpp_aligned_new
+
+static void* allocate(size_t arg_size, std::align_val_t arg_align) {
+    nAllocs++;
+    const size_t align = static_cast<size_t> (arg_align);
+    // aligned_alloc wants a multiple of the alignment.
+    if (void* ptr = std::aligned_alloc(align, (std::max<size_t>(arg_size, 1) + align - 1) / align * align)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t arg_size, std::align_val_t arg_align) {
+    return allocate(arg_size, arg_align);
+}
+
+void* operator new[](size_t arg_size, std::align_val_t arg_align) {
+    return allocate(arg_size, arg_align);
+}
+
+void operator delete(void* arg_ptr, std::align_val_t) noexcept {
+    std::free(arg_ptr);
+}
+
+void operator delete[](void* arg_ptr, std::align_val_t) noexcept {
+    std::free(arg_ptr);
+}
+
+void operator delete(void* arg_ptr, size_t, std::align_val_t) noexcept {
+    std::free(arg_ptr);
+}
+
+void operator delete[](void* arg_ptr, size_t, std::align_val_t) noexcept {
+    std::free(arg_ptr);
+}
+#endif
+
+/**
+ * Gives access to the record loop of the interpreter.
+ */
+class BenchScript : public ElvasScript {
+public:
+
+    BenchScript(std::istream& arg_is, std::ostream& arg_os) : ElvasScript(arg_is, arg_os) {
+    }
+
+    void dataset(const std::vector<double>& arg_datasetVals) {
+        _beginFunc(_datasetVarSlots, arg_datasetVals);
+    }
+
+    void record(const std::vector<double>& arg_recordVals) {
+        _mainFunc(_recordVarSlots, arg_recordVals);
+    }
+};
+
+/**
+ * Times a function and prints the result as one JSON object of an array.
+ * Each call of the function processes arg_unitsPerCall units, e.g.
+ * records, and the rate is given in units per second.
+ */
+class Bench {
+    std::ostream& _out;
+    bool _isFirst;
+public:
+
+    Bench(std::ostream& arg_out) : _out(arg_out), _isFirst(true) {
+        _out << "[";
+    }
+
+    ~Bench() {
+        _out << "\n]" << std::endl;
+    }
+
+    template<class Func>
+    void run(const std::string& arg_name, const std::string& arg_unit, const size_t& arg_n, const size_t& arg_unitsPerCall, Func&& arg_func) {
+        size_t n = std::max<size_t>(arg_n / 10, 1);
+        for (size_t i = 0; i < n; i++) {
+            arg_func(i);
+        }
+        size_t allocs = nAllocs;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < arg_n; i++) {
+            arg_func(i);
+        }
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        allocs = nAllocs - allocs;
+        size_t count = arg_n * arg_unitsPerCall;
+        _out << (_isFirst ? (_isFirst = false, "\n") : ",\n");
+        _out << "  {\"name\": \"" << arg_name << "\", \"unit\": \"" << arg_unit << "\", \"count\": " << count
+                << ", \"seconds\": " << sec << ", \"per_second\": " << count / sec
+                << ", \"allocs_per_unit\": " << (double) allocs / count << "}";
+    }
+
+    template<class Func>
+    void run(const std::string& arg_name, const std::string& arg_unit, const size_t& arg_n, Func&& arg_func) {
+        run(arg_name, arg_unit, arg_n, 1, arg_func);
+    }
+
+    /**
+     * Prints a measured quantity other than a rate, such as an error.
+     */
+    void value(const std::string& arg_name, const std::string& arg_key, const double& arg_value) {
+        _out << (_isFirst ? (_isFirst = false, "\n") : ",\n");
+        _out << "  {\"name\": \"" << arg_name << "\", \"" << arg_key << "\": " << arg_value << "}";
+    }
+};
+
+static volatile double sink;
+
+/**
+ * The routines of sm.in without comments.
+ */
+static const char* smScript =
+        "[GENERAL]\n"
+        "DATASET_VARS = {mHiggs, mTop}\n"
+        "RECORD_VARS = {Q, g2, g1, yt, yb, lambda}\n"
+        "DATASET_DELIM = \" \"\n"
+        "RECORD_DELIM = \" \"\n"
+        "OUTPUT_DELIM = \" \"\n"
+        "[INITIALIZE]\n"
+        "LN_QR = 0.\n"
+        "lnVg = log(2. * pi^2)\n"
+        "upper_bound = log(2.435e18)\n"
+        "[BEGIN_ROUTINE]\n"
+        "initialize()\n"
+        "lower_bound = log(mTop * 10)\n"
+        "[MAIN_ROUTINE]\n"
+        "HIGGS_QUARTIC_COUPLING = lambda\n"
+        "if(HIGGS_QUARTIC_COUPLING > 0, continue())\n"
+        "LN_RINV = log(Q) - LN_QR\n"
+        "if(LN_RINV > upper_bound + log(10) | LN_RINV < lower_bound - log(10), continue())\n"
+        "tree = InstantonB()\n"
+        "higgsQC = HiggsQC()\n"
+        "topQC = 3. * FermionQC(yt)\n"
+        "WbosonQC = 2. * GaugeQC(g2^2 / 4.)\n"
+        "ZbosonQC = GaugeQC((g2^2 + g1^2 * 3. / 5.) / 4.)\n"
+        "totalQC = higgsQC + topQC + WbosonQC + ZbosonQC\n"
+        "maxQC = max(abs(topQC), abs(WbosonQC), abs(ZbosonQC), abs(higgsQC))\n"
+        "if(maxQC > 0.8 * tree | abs(totalQC) > 0.8 * tree, continue())\n"
+        "save_phiC()\n"
+        "save_lndgamma_dRinv(lnVg + 4. * LN_RINV - tree - totalQC)\n"
+        "[END_ROUTINE]\n"
+        "lngamma = if(is_data_enough(), eval(lnRinv_minimum = get_min_lnRinv(lower_bound), "
+        "lnRinv_maximum = get_max_lnRinv(upper_bound), "
+        "if(lnRinv_maximum > lnRinv_minimum, get_lngamma(lnRinv_minimum, lnRinv_maximum), -inf)), -inf)\n"
+        "print(mHiggs, mTop, (lngamma + 378.229) / log(10))\n";
+
+/**
+ * [GENERAL] only, so that analyze does nothing but read the records.
+ */
+static const char* parseScript =
+        "[GENERAL]\n"
+        "DATASET_VARS = {mHiggs, mTop}\n"
+        "RECORD_VARS = {Q, g2, g1, yt, yb, lambda}\n"
+        "DATASET_DELIM = \" \"\n"
+        "RECORD_DELIM = \" \"\n";
+
+/**
+ * An expression nested arg_depth times, going through every level of the
+ * grammar at each step: power, product, sum, relation, and, or, if and a
+ * function call.
+ */
+static std::string nestedExpression(const size_t& arg_depth) {
+    std::string expr = "x";
+    for (size_t i = 0; i < arg_depth; i++) {
+        switch (i % 3) {
+            case 0:
+                expr = "-(" + expr + ")^2 * y / 2 + z";
+                break;
+            case 1:
+                expr = "if((" + expr + ") < 1 & x | y >= 2, log(x), 1)";
+                break;
+            default:
+                expr = "max(x, (" + expr + ")^y - 1)";
+                break;
+        }
+    }
+    return expr;
+}
+
+int main(int argc, char** argv) {
+    namespace po = boost::program_options;
+    po::options_description desc("Usage: ./elvas_bench [options]\nAllowed options");
+    desc.add_options()
+            ("help,h", "display this help message")
+            ("datasets,d", po::value<size_t>()->default_value(100), "number of synthetic datasets")
+            ("records,r", po::value<size_t>()->default_value(191), "number of records per dataset")
+            ("calls,n", po::value<size_t>()->default_value(1000000), "number of calls of the per-record benchmarks")
+            ("repeat", po::value<size_t>()->default_value(3), "number of runs of the whole-input benchmarks")
+            ("depth", po::value<size_t>()->default_value(300), "nesting depth of the expression parsed by parse_nested")
+            ("write,w", po::value<std::string>(), "write the synthetic data to a file and exit");
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+    if (vm.count("help")) {
+        std::cout << desc << std::endl;
+        return 0;
+    }
+    const size_t nDatasets = vm["datasets"].as<size_t>(), nRecords = vm["records"].as<size_t>();
+    const size_t n = vm["calls"].as<size_t>(), repeat = vm["repeat"].as<size_t>(), depth = vm["depth"].as<size_t>();
+
+    std::ostringstream data;
+    SyntheticData::write(data, nDatasets, nRecords);
+    if (vm.count("write")) {
+        std::ofstream ofs(vm["write"].as<std::string>());
+        ofs << data.str();
+        return ofs ? 0 : 1;
+    }
+    const std::string dataStr = data.str();
+
+    std::vector<std::vector<double>> records = SyntheticData::records(125.09, 173.1, std::max<size_t>(nRecords, 3));
+    // The inputs of the kernels and the lndgamma table are taken from as
+    // many records as by default whatever -r is, so that the table covers
+    // the region of integration of get_lngamma.
+    const std::vector<std::vector<double>> samples = SyntheticData::records(125.09, 173.1, 191);
+    std::vector<double> lambdaAbs, lnQR, yt, gSquared;
+    for (const auto& record : samples) {
+        if (record[5] < 0) {
+            lambdaAbs.emplace_back(-record[5]);
+            lnQR.emplace_back(0.);
+            yt.emplace_back(record[3]);
+            gSquared.emplace_back(record[1] * record[1] / 4.);
+        }
+    }
+    if (lambdaAbs.empty()) {
+        std::cerr << "The synthetic records have no negative quartic coupling." << std::endl;
+        return 1;
+    }
+    const size_t nNegative = lambdaAbs.size();
+
+    std::vector<std::pair<double, double>> lndgamma;
+    for (const auto& record : samples) {
+        if (record[5] < 0) {
+            const double lnRinv = std::log(record[0]);
+            lndgamma.emplace_back(lnRinv, std::log(2. * M_PI * M_PI) + 4. * lnRinv - Elvas::instantonB(-record[5]));
+        }
+    }
+    std::sort(lndgamma.begin(), lndgamma.end());
+    const double lnRinvBeg = lndgamma.front().first, lnRinvEnd = lndgamma.back().first;
+
+    Bench bench(std::cout);
+
+    auto analyze = [&dataStr](const char* arg_script, const bool& arg_columnar) {
+        std::istringstream is(std::string(arg_script) + dataStr);
+        std::ostringstream os;
+        ElvasScript script(is, os);
+        script.setColumnar(arg_columnar);
+        script.analyze();
+        sink = os.str().size();
+    };
+    bench.run("parse_records", "record", repeat, nDatasets * nRecords, [&](size_t) {
+        analyze(parseScript, false);
+    });
+    bench.run("sm_end_to_end", "record", repeat, nDatasets * nRecords, [&](size_t) {
+        analyze(smScript, false);
+    });
+    bench.run("sm_end_to_end_columnar", "record", repeat, nDatasets * nRecords, [&](size_t) {
+        analyze(smScript, true);
+    });
+
+    auto parse = [](const std::string& arg_expr) {
+        namespace x3 = boost::spirit::x3;
+        AST::Expression ast;
+        auto it = arg_expr.begin();
+        sink = x3::phrase_parse(it, arg_expr.end(), Parser::Expression, x3::ascii::space, ast);
+    };
+    std::vector<std::string> smLines;
+    {
+        std::istringstream smIs(smScript);
+        std::string line;
+        bool isGeneral = false;
+        while (std::getline(smIs, line)) {
+            if (line.size() != 0 && line[0] == '[') {
+                isGeneral = line == "[GENERAL]";
+            } else if (!isGeneral && line.find('"') == std::string::npos) {
+                smLines.emplace_back(line);
+            }
+        }
+    }
+    size_t smBytes = 0;
+    for (const auto& line : smLines) {
+        smBytes += line.size();
+    }
+    bench.run("parse_sm_expressions", "byte", std::max<size_t>(n / 1000, 1), smBytes, [&](size_t) {
+        for (const auto& line : smLines) {
+            parse(line);
+        }
+    });
+    const std::string nested = nestedExpression(depth);
+    bench.run("parse_nested", "byte", std::max<size_t>(n / 10000, 1), nested.size(), [&](size_t) {
+        parse(nested);
+    });
+
+    // Every records.size() records start a new dataset, as in sm.dat, so
+    // that initialize() empties the tables that save_* fills.
+    std::istringstream smIs(std::string(smScript) + "[DATASET] (125.09 173.1)\n2.4e2 0.646 0.463 0.919 0.0152 0.120\n");
+    std::ostringstream smOs;
+    BenchScript smRecords(smIs, smOs);
+    smRecords.analyze();
+    const std::vector<double> datasetVals{125.09, 173.1};
+    bench.run("main_routine", "record", n, [&](size_t arg_i) {
+        if (arg_i % records.size() == 0) {
+            smRecords.dataset(datasetVals);
+        }
+        smRecords.record(records[arg_i % records.size()]);
+    });
+
+    bench.run("get_lngamma", "call", std::max<size_t>(n / 1000, 1), [&](size_t) {
+        sink = Elvas::getLnGamma(lndgamma, lnRinvBeg, lnRinvEnd);
+    });
+    bench.run("get_lngamma_adaptive", "call", std::max<size_t>(n / 1000, 1), [&](size_t) {
+        size_t nEval;
+        double error;
+        sink = Elvas::getLnGamma(lndgamma, lnRinvBeg, lnRinvEnd, 1e-8, nEval, error);
+    });
+    bench.run("interpolate_l2", "call", n, [&](size_t arg_i) {
+        const double x = lnRinvBeg + (lnRinvEnd - lnRinvBeg) * (arg_i & 1023) / 1024.;
+        sink = NTools::interpolateL2(lndgamma.begin(), lndgamma.end(), x);
+    });
+
+    // Two-loop SM running from 240 GeV over 36 decades, below the Landau
+    // pole of g1, sampled at as many scales as the synthetic records.
+    const double rgStart[6] = {records[0][2], records[0][1], 1.1305, records[0][3], records[0][4], records[0][5]};
+    bench.run("rge_sm", "record", std::max<size_t>(n / 10000, 1), nRecords, [&](size_t) {
+        RGESolver solver(6, Elvas::smBeta);
+        double y[6];
+        std::copy(rgStart, rgStart + 6, y);
+        const double lnQBeg = std::log(240.), dlnQ = 36. * std::log(10.) / std::max<size_t>(nRecords - 1, 1);
+        double lnQ = lnQBeg;
+        for (size_t i = 1; i < nRecords; i++) {
+            solver.evolve(lnQ, y, lnQBeg + i * dlnQ);
+        }
+        sink = y[5];
+    });
+
+    bench.run("instanton_b", "call", n, [&](size_t arg_i) {
+        sink = Elvas::instantonB(lambdaAbs[arg_i % nNegative]);
+    });
+    bench.run("higgs_qc", "call", n, [&](size_t arg_i) {
+        sink = Elvas::higgsQC(lambdaAbs[arg_i % nNegative], 0.);
+    });
+    bench.run("scalar_qc", "call", n, [&](size_t arg_i) {
+        sink = Elvas::scalarQC(gSquared[arg_i % nNegative], lambdaAbs[arg_i % nNegative], 0.);
+    });
+    bench.run("fermion_qc", "call", n, [&](size_t arg_i) {
+        sink = Elvas::fermionQC(yt[arg_i % nNegative], lambdaAbs[arg_i % nNegative], 0.);
+    });
+    bench.run("gauge_qc", "call", n, [&](size_t arg_i) {
+        sink = Elvas::gaugeQC(gSquared[arg_i % nNegative], lambdaAbs[arg_i % nNegative], 0.);
+    });
+
+    std::vector<double> out(nNegative);
+    const size_t nBatches = std::max<size_t>(n / nNegative, 1);
+    bench.run("instanton_b_batch", "value", nBatches, nNegative, [&](size_t) {
+        Elvas::instantonB(lambdaAbs.data(), out.data(), nNegative);
+        sink = out[0];
+    });
+    bench.run("higgs_qc_batch", "value", nBatches, nNegative, [&](size_t) {
+        Elvas::higgsQC(lambdaAbs.data(), lnQR.data(), out.data(), nNegative);
+        sink = out[0];
+    });
+    bench.run("scalar_qc_batch", "value", nBatches, nNegative, [&](size_t) {
+        Elvas::scalarQC(gSquared.data(), lambdaAbs.data(), lnQR.data(), out.data(), nNegative);
+        sink = out[0];
+    });
+    bench.run("fermion_qc_batch", "value", nBatches, nNegative, [&](size_t) {
+        Elvas::fermionQC(yt.data(), lambdaAbs.data(), lnQR.data(), out.data(), nNegative);
+        sink = out[0];
+    });
+    bench.run("gauge_qc_batch", "value", nBatches, nNegative, [&](size_t) {
+        Elvas::gaugeQC(gSquared.data(), lambdaAbs.data(), lnQR.data(), out.data(), nNegative);
+        sink = out[0];
+    });
+
+    // GaugeQC from a table, and its largest error against the closed form
+    // over x from 1/2 to 2^14, relative to max(1, |value|).
+    const size_t nSweep = 100000;
+    std::vector<double> xs(nSweep);
+    for (size_t i = 0; i < nSweep; i++) {
+        xs[i] = std::ldexp(1., -1) * std::pow(2., 15. * i / nSweep);
+    }
+    auto sweep = [&xs](double (*arg_qc)(const double&, const double&, const double&), const bool& arg_isSquared) {
+        std::vector<double> values;
+        for (const auto& x : xs) {
+            values.emplace_back(arg_qc(arg_isSquared ? std::sqrt(x) : x, 1., 0.));
+        }
+        return values;
+    };
+    const std::vector<double> gaugeClosed = sweep(Elvas::gaugeQC, false);
+    Elvas::setKernels('T');
+    bench.run("gauge_qc_table", "call", n, [&](size_t arg_i) {
+        sink = Elvas::gaugeQC(gSquared[arg_i % nNegative], lambdaAbs[arg_i % nNegative], 0.);
+    });
+    bench.run("gauge_qc_table_batch", "value", nBatches, nNegative, [&](size_t) {
+        Elvas::gaugeQC(gSquared.data(), lambdaAbs.data(), lnQR.data(), out.data(), nNegative);
+        sink = out[0];
+    });
+    auto maxError = [](const std::vector<double>& arg_table, const std::vector<double>& arg_closed) {
+        double error = 0.;
+        for (size_t i = 0; i < arg_table.size(); i++) {
+            error = std::max(error, std::fabs(arg_table[i] - arg_closed[i]) / std::max(1., std::fabs(arg_closed[i])));
+        }
+        return error;
+    };
+    bench.value("gauge_qc_table_error", "max_error", maxError(sweep(Elvas::gaugeQC, false), gaugeClosed));
+    bench.value("qc_table_error_bound", "max_error", Elvas::tableError());
+    Elvas::setKernels('C');
+    return 0;
+}
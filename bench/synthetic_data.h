@@ -0,0 +1,102 @@
+/**
+ * @file synthetic_data.h
+ * @brief Synthetic RG data shaped like sm.dat for the benchmarks
+ * @date Created on: 2026/10/17, 20:50
+ */
+
+#ifndef SYNTHETIC_DATA_H
+#define SYNTHETIC_DATA_H
+
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+/**
+ * Standard Model couplings run with the one-loop RGEs from 240 GeV up to
+ * 38 decades above, with the same columns as sm.dat: Q, g2, g1, yt, yb
+ * and lambda. The top Yukawa and the Higgs quartic coupling at the start
+ * scale with mTop and mHiggs, so that each dataset is slightly different
+ * and the quartic coupling turns negative in the middle of the range.
+ */
+class SyntheticData {
+
+    static void _beta(const double* arg_y, double* arg_dy) {
+        const double g1 = arg_y[0], g2 = arg_y[1], g3 = arg_y[2], yt = arg_y[3], yb = arg_y[4], lambda = arg_y[5];
+        const double g1s = g1 * g1, g2s = g2 * g2, g3s = g3 * g3, yts = yt * yt, ybs = yb * yb;
+        const double loop = 1. / (16. * M_PI * M_PI);
+        arg_dy[0] = loop * 41. / 10. * g1s * g1;
+        arg_dy[1] = -loop * 19. / 6. * g2s * g2;
+        arg_dy[2] = -loop * 7. * g3s * g3;
+        arg_dy[3] = loop * yt * (9. / 2. * yts + 3. / 2. * ybs - 17. / 20. * g1s - 9. / 4. * g2s - 8. * g3s);
+        arg_dy[4] = loop * yb * (9. / 2. * ybs + 3. / 2. * yts - 1. / 4. * g1s - 9. / 4. * g2s - 8. * g3s);
+        arg_dy[5] = loop * (24. * lambda * lambda + lambda * (12. * yts + 12. * ybs - 9. * g2s - 9. / 5. * g1s)
+                - 6. * yts * yts - 6. * ybs * ybs + 3. / 8. * (2. * g2s * g2s + std::pow(g2s + 3. / 5. * g1s, 2)));
+    }
+
+    static void _rk4(double* arg_y, const double& arg_dt) {
+        const int n = 6;
+        double k1[n], k2[n], k3[n], k4[n], temp[n];
+        _beta(arg_y, k1);
+        for (int i = 0; i < n; i++) temp[i] = arg_y[i] + .5 * arg_dt * k1[i];
+        _beta(temp, k2);
+        for (int i = 0; i < n; i++) temp[i] = arg_y[i] + .5 * arg_dt * k2[i];
+        _beta(temp, k3);
+        for (int i = 0; i < n; i++) temp[i] = arg_y[i] + arg_dt * k3[i];
+        _beta(temp, k4);
+        for (int i = 0; i < n; i++) {
+            arg_y[i] += arg_dt / 6. * (k1[i] + 2. * k2[i] + 2. * k3[i] + k4[i]);
+        }
+    }
+
+public:
+
+    /**
+     * Dataset variables {mHiggs, mTop} of the arg_i-th dataset, spread
+     * over a few GeV around the measured values.
+     */
+    static std::vector<double> datasetVals(const size_t& arg_i) {
+        const double u = std::fmod(arg_i * 0.6180339887, 1.), v = std::fmod(arg_i * 0.4142135624, 1.);
+        return {124.5 + 1.2 * u, 171.9 + 2.4 * v};
+    }
+
+    /**
+     * arg_nRecords records {Q, g2, g1, yt, yb, lambda} equally spaced in
+     * ln Q.
+     */
+    static std::vector<std::vector<double>> records(const double& arg_mHiggs, const double& arg_mTop, const size_t& arg_nRecords) {
+        const double lnQBeg = std::log(240.), lnQEnd = lnQBeg + 38. * std::log(10.);
+        const int nSteps = 8;
+        double y[6] = {0.46302, 0.64592, 1.1305, 0.91869 * arg_mTop / 173.1, 0.015218, 0.11956 * std::pow(arg_mHiggs / 125.09, 2)};
+        const double dlnQ = arg_nRecords > 1 ? (lnQEnd - lnQBeg) / (arg_nRecords - 1) : 0.;
+        std::vector<std::vector<double>> result;
+        for (size_t i = 0; i < arg_nRecords; i++) {
+            if (i > 0) {
+                for (int step = 0; step < nSteps; step++) {
+                    _rk4(y, dlnQ / nSteps);
+                }
+            }
+            result.push_back({std::exp(lnQBeg + i * dlnQ), y[1], y[0], y[3], y[4], y[5]});
+        }
+        return result;
+    }
+
+    /**
+     * Writes arg_nDatasets [DATASET] sections in the format of sm.dat.
+     */
+    static void write(std::ostream& arg_os, const size_t& arg_nDatasets, const size_t& arg_nRecords) {
+        arg_os << std::scientific << std::setprecision(7);
+        for (size_t i = 0; i < arg_nDatasets; i++) {
+            std::vector<double> vals = datasetVals(i);
+            arg_os << "[DATASET] (" << vals[0] << " " << vals[1] << ")\n";
+            for (const auto& record : records(vals[0], vals[1], arg_nRecords)) {
+                for (size_t var = 0; var < record.size(); var++) {
+                    arg_os << (var ? " " : "") << record[var];
+                }
+                arg_os << "\n";
+            }
+        }
+    }
+};
+
+#endif /* SYNTHETIC_DATA_H */
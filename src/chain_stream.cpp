@@ -0,0 +1,77 @@
+/**
+ * @file chain_stream.cpp
+ * @brief Input stream reading several files in sequence
+ * @date Created on: 2026/10/17, 17:30
+ */
+
+#include "include/chain_stream.h"
+
+ChainStreamBuf::ChainStreamBuf(const std::vector<std::string>& arg_paths, const size_t& arg_bufSize)
+: _paths(arg_paths), _next(0), _buf(arg_bufSize), _starts(arg_paths.size()), _pos(0) {
+    for (const auto& path : _paths) {
+        if (!std::ifstream(path)) {
+            throw std::runtime_error("File open error. (" + path + ")");
+        }
+    }
+}
+
+ChainStreamBuf::int_type ChainStreamBuf::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+    _pos += egptr() - eback();
+    setg(_buf.data(), _buf.data(), _buf.data());
+    while (true) {
+        if (_file.is_open()) {
+            std::streamsize size = _file.sgetn(_buf.data(), _buf.size());
+            if (size > 0) {
+                setg(_buf.data(), _buf.data(), _buf.data() + size);
+                return traits_type::to_int_type(*gptr());
+            }
+            _file.close();
+        }
+        if (_next == _paths.size()) {
+            return traits_type::eof();
+        }
+        if (!_file.open(_paths.at(_next), std::ios::in)) {
+            throw std::runtime_error("File open error. (" + _paths.at(_next) + ")");
+        }
+        _starts.at(_next) = _pos;
+        _next++;
+    }
+}
+
+ChainStreamBuf::pos_type ChainStreamBuf::seekoff(off_type arg_off, std::ios_base::seekdir arg_dir, std::ios_base::openmode arg_which) {
+    if (arg_dir == std::ios_base::beg) {
+        return seekpos(pos_type(arg_off), arg_which);
+    }
+    if (arg_dir != std::ios_base::cur || !(arg_which & std::ios_base::in)) {
+        return pos_type(off_type(-1));
+    }
+    const off_type pos = _pos + (gptr() - eback()) + arg_off;
+    return arg_off == 0 ? pos_type(pos) : seekpos(pos_type(pos), arg_which);
+}
+
+ChainStreamBuf::pos_type ChainStreamBuf::seekpos(pos_type arg_pos, std::ios_base::openmode arg_which) {
+    const off_type pos = arg_pos;
+    size_t file = _next;
+    while (file > 0 && _starts.at(file - 1) > pos) {
+        file--;
+    }
+    if (file == 0 || pos < 0 || !(arg_which & std::ios_base::in)) {
+        return pos_type(off_type(-1));
+    }
+    if (file != _next || !_file.is_open()) {
+        _file.close();
+        if (!_file.open(_paths.at(file - 1), std::ios::in)) {
+            return pos_type(off_type(-1));
+        }
+        _next = file;
+    }
+    if (_file.pubseekpos(pos - _starts.at(file - 1), std::ios::in) == pos_type(off_type(-1))) {
+        return pos_type(off_type(-1));
+    }
+    _pos = pos;
+    setg(_buf.data(), _buf.data(), _buf.data());
+    return arg_pos;
+}
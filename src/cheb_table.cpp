@@ -0,0 +1,79 @@
+/**
+ * @file cheb_table.cpp
+ * @brief Piecewise Chebyshev approximation of smooth functions
+ * @date Created on: 2026/10/17, 23:59
+ */
+
+#include "include/cheb_table.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const int nSamples = 64;
+    const long double pi = 3.14159265358979323846264338327950288L;
+
+    double fromBits(const uint64_t& arg_bits) {
+        double x;
+        std::memcpy(&x, &arg_bits, sizeof (x));
+        return x;
+    }
+}
+
+ChebTable::ChebTable(const std::function<double(const double&)>& arg_f, const int& arg_expMin, const int& arg_expMax, const int& arg_log2Pieces, const int& arg_degree)
+: _xMin(std::ldexp(1., arg_expMin)), _xMax(std::ldexp(1., arg_expMax)), _shift(52 - arg_log2Pieces), _stride(arg_degree + 3), _maxError(0.) {
+    if (!(arg_expMin < arg_expMax) || arg_log2Pieces < 0 || arg_log2Pieces > 20 || arg_degree < 0) {
+        throw ChebTableError("ChebTable: Invalid range, pieces or degree.");
+    }
+    std::memcpy(&_first, &_xMin, sizeof (_first));
+    _first >>= _shift;
+    const size_t nPieces = (size_t) (arg_expMax - arg_expMin) << arg_log2Pieces;
+    const int n = arg_degree + 1;
+    _coeffs.resize(nPieces * _stride);
+    std::vector<long double> values(n), cheb(n), monomial(n), prev(n), curr(n), next(n);
+    for (size_t piece = 0; piece < nPieces; piece++) {
+        const double a = fromBits((_first + piece) << _shift), b = fromBits((_first + piece + 1) << _shift);
+        const double center = .5 * (a + b), halfWidth = .5 * (b - a);
+        for (int j = 0; j < n; j++) {
+            values[j] = arg_f(center + halfWidth * (double) std::cos(pi * (j + .5) / n));
+            if (!std::isfinite((double) values[j])) {
+                throw ChebTableError("ChebTable: The function is not finite on the range.");
+            }
+        }
+        for (int k = 0; k < n; k++) {
+            long double sum = 0.;
+            for (int j = 0; j < n; j++) {
+                sum += values[j] * std::cos(pi * k * (j + .5) / n);
+            }
+            cheb[k] = sum * (k == 0 ? 1. : 2.) / n;
+        }
+
+        // From the Chebyshev basis to powers of the position in the piece,
+        // with T(k + 1) = 2 t T(k) - T(k - 1).
+        std::fill(monomial.begin(), monomial.end(), 0.);
+        std::fill(prev.begin(), prev.end(), 0.);
+        std::fill(curr.begin(), curr.end(), 0.);
+        prev[0] = 1.;
+        monomial[0] = cheb[0];
+        if (n > 1) {
+            curr[1] = 1.;
+            monomial[1] = cheb[1];
+        }
+        for (int k = 2; k < n; k++) {
+            for (int i = 0; i < n; i++) {
+                next[i] = (i > 0 ? 2. * curr[i - 1] : 0.) - prev[i];
+                monomial[i] += cheb[k] * next[i];
+            }
+            std::swap(prev, curr);
+            std::swap(curr, next);
+        }
+        double* c = _coeffs.data() + piece * _stride;
+        c[0] = center;
+        c[1] = 1. / halfWidth;
+        std::copy(monomial.begin(), monomial.end(), c + 2);
+
+        for (int i = 0; i < nSamples; i++) {
+            const double x = a + (b - a) * i / nSamples, fx = arg_f(x);
+            _maxError = std::max(_maxError, std::fabs((*this)(x) - fx) / std::max(1., std::fabs(fx)));
+        }
+    }
+}
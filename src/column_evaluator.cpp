@@ -0,0 +1,502 @@
+/**
+ * @file column_evaluator.cpp
+ * @brief Column-wise execution of routines over the records of a dataset
+ * @date Created on: 2026/10/17, 19:20
+ */
+
+#include "include/column_evaluator.h"
+#include <algorithm>
+
+namespace {
+
+    /**
+     * Stores arg_func(i) into arg_dst[i] for the masked records. The select
+     * keeps the loop free of branches.
+     */
+    template<class Func>
+    void masked(const std::vector<char>& arg_mask, double* arg_dst, Func arg_func) {
+        const char* mask = arg_mask.data();
+        for (size_t i = 0; i < arg_mask.size(); i++) {
+            double val = arg_func(i);
+            arg_dst[i] = mask[i] ? val : arg_dst[i];
+        }
+    }
+}
+
+const size_t ASTReader::ColumnEvaluator::chunkSize;
+
+bool ASTReader::ColumnEvaluator::_check(const Program& arg_prog, std::vector<char>& arg_defined, std::vector<const Program*>& arg_stack) const {
+    const bool isBody = !arg_stack.empty();
+    const size_t codeSize = arg_prog.code.size();
+    std::vector<std::vector<char>> states(codeSize + 1);
+    states[0] = arg_defined;
+    auto merge = [&states](const size_t& arg_pc, const std::vector<char>& arg_state) {
+        std::vector<char>& state = states.at(arg_pc);
+        if (state.empty()) {
+            state = arg_state;
+        } else {
+            for (size_t i = 0; i < state.size(); i++) {
+                state[i] = state[i] && arg_state[i];
+            }
+        }
+    };
+
+    for (size_t pc = 0; pc < codeSize; pc++) {
+        if (states[pc].empty()) {
+            continue;
+        }
+        std::vector<char> state = std::move(states[pc]);
+        auto isReadable = [this, &state](const int32_t & arg_slot) {
+            return state[arg_slot] || (!_isStored[arg_slot] && _eval._isSet[arg_slot]);
+        };
+        const Instruction& inst = arg_prog.code[pc];
+        switch (inst.op) {
+            case OpCode::LoadVar:
+                if (!isReadable(inst.a)) {
+                    return false;
+                }
+                break;
+            case OpCode::StoreVar:
+                if (isBody) {
+                    return false;
+                }
+                state[inst.a] = true;
+                break;
+            case OpCode::Define:
+                return false;
+            case OpCode::Call:
+            {
+                const CallSite& site = arg_prog.calls[inst.b];
+                if (site.func < 0 || (size_t) site.func >= _eval._funcTable.size() || !_eval._funcTable[site.func].isSet()
+                        || !_eval._funcTable[site.func].accepts(site.argNum)) {
+                    return false;
+                }
+                const Function& func = _eval._funcTable[site.func];
+                if (func.builtin) {
+                    if (!func.batch || !std::all_of(func.reads.begin(), func.reads.end(), isReadable)) {
+                        return false;
+                    }
+                } else {
+                    if (std::find(arg_stack.begin(), arg_stack.end(), func.body.get()) != arg_stack.end()) {
+                        return false;
+                    }
+                    arg_stack.emplace_back(func.body.get());
+                    std::vector<char> bodyState = state;
+                    bool isAccepted = _check(*func.body, bodyState, arg_stack);
+                    arg_stack.pop_back();
+                    if (!isAccepted) {
+                        return false;
+                    }
+                }
+                break;
+            }
+            case OpCode::Jump:
+                merge(inst.dst, state);
+                continue;
+            case OpCode::JumpIfFalse:
+            case OpCode::JumpIfTrue:
+                merge(inst.dst, state);
+                break;
+            default:
+                break;
+        }
+        merge(pc + 1, state);
+    }
+    if (!states[codeSize].empty()) {
+        arg_defined = std::move(states[codeSize]);
+    }
+    return true;
+}
+
+bool ASTReader::ColumnEvaluator::prepare(const std::vector<Program>& arg_progs, const std::vector<int32_t>& arg_recordSlots) {
+    _eval._fitFrame();
+    const size_t nSlots = _eval._frame.size();
+    _isRecord.assign(nSlots, false);
+    for (const auto& slot : arg_recordSlots) {
+        _isRecord.at(slot) = true;
+    }
+    _isStored.assign(nSlots, false);
+    _storedSlots.clear();
+    for (const auto& prog : arg_progs) {
+        for (const auto& inst : prog.code) {
+            if (inst.op == OpCode::StoreVar && !_isRecord[inst.a] && !_isStored[inst.a]) {
+                _isStored[inst.a] = true;
+                _storedSlots.emplace_back(inst.a);
+            }
+        }
+    }
+
+    std::vector<char> defined(_isRecord);
+    for (const auto& prog : arg_progs) {
+        std::vector<const Program*> stack;
+        if (!_check(prog, defined, stack)) {
+            _progs = nullptr;
+            return false;
+        }
+    }
+    _progs = &arg_progs;
+    _recordSlots = arg_recordSlots;
+    return true;
+}
+
+std::vector<double> ASTReader::ColumnEvaluator::_run(const Program& arg_prog, const std::vector<const double*>& arg_args, const std::vector<char>& arg_active) {
+    const size_t n = _size;
+    const int32_t codeSize = arg_prog.code.size();
+    std::vector<double> regs(std::max<size_t>(arg_prog.nRegs, 1) * n);
+    for (size_t arg = 0; arg < arg_args.size(); arg++) {
+        std::copy(arg_args[arg], arg_args[arg] + n, regs.begin() + arg * n);
+    }
+    auto reg = [&regs, n](const int32_t & arg_reg) {
+        return regs.data() + arg_reg * n;
+    };
+
+    // While every running record is at the same pc, the mask stays the
+    // entry mask and pcs is not updated.
+    std::vector<char> mask(arg_active);
+    const size_t nRunning = std::count(mask.begin(), mask.end(), true);
+    bool isUniform = true;
+    std::vector<int32_t> pcs(n, codeSize);
+    for (int32_t pc = 0; pc < codeSize; pc++) {
+        if (!isUniform) {
+            size_t nReached = 0;
+            for (size_t i = 0; i < n; i++) {
+                mask[i] = pcs[i] == pc;
+                nReached += mask[i];
+            }
+            if (nReached == 0) {
+                continue;
+            }
+            isUniform = nReached == nRunning;
+        }
+
+        const Instruction& inst = arg_prog.code[pc];
+        int32_t next = pc + 1;
+        switch (inst.op) {
+            case OpCode::LoadNum:
+            {
+                const double num = arg_prog.numbers[inst.a];
+                masked(mask, reg(inst.dst), [num](size_t) {
+                    return num;
+                });
+                break;
+            }
+            case OpCode::LoadVar:
+                if (!_columns[inst.a].empty()) {
+                    const double* column = _columns[inst.a].data();
+                    masked(mask, reg(inst.dst), [column](size_t i) {
+                        return column[i];
+                    });
+                } else {
+                    const double val = _eval._frame[inst.a];
+                    masked(mask, reg(inst.dst), [val](size_t) {
+                        return val;
+                    });
+                }
+                break;
+            case OpCode::StoreVar:
+            {
+                const double* src = reg(inst.dst);
+                masked(mask, _columns[inst.a].data(), [src](size_t i) {
+                    return src[i];
+                });
+                std::vector<char>& written = _written[inst.a];
+                for (size_t i = 0; i < n; i++) {
+                    written[i] = written[i] || mask[i];
+                }
+                break;
+            }
+            case OpCode::Move:
+            {
+                const double* a = reg(inst.a);
+                masked(mask, reg(inst.dst), [a](size_t i) {
+                    return a[i];
+                });
+                break;
+            }
+            case OpCode::Neg:
+            {
+                const double* a = reg(inst.a);
+                masked(mask, reg(inst.dst), [a](size_t i) {
+                    return -a[i];
+                });
+                break;
+            }
+            case OpCode::Add:
+            {
+                const double *a = reg(inst.a), *b = reg(inst.b);
+                masked(mask, reg(inst.dst), [a, b](size_t i) {
+                    return a[i] + b[i];
+                });
+                break;
+            }
+            case OpCode::Mul:
+            {
+                const double *a = reg(inst.a), *b = reg(inst.b);
+                masked(mask, reg(inst.dst), [a, b](size_t i) {
+                    return a[i] * b[i];
+                });
+                break;
+            }
+            case OpCode::Div:
+            {
+                const double *a = reg(inst.a), *b = reg(inst.b);
+                masked(mask, reg(inst.dst), [a, b](size_t i) {
+                    return a[i] / b[i];
+                });
+                break;
+            }
+            case OpCode::Pow:
+            {
+                const double *a = reg(inst.a), *b = reg(inst.b);
+                double* dst = reg(inst.dst);
+                for (size_t i = 0; i < n; i++) {
+                    if (mask[i]) {
+                        dst[i] = pow(a[i], b[i]);
+                    }
+                }
+                break;
+            }
+            case OpCode::PowInt:
+            {
+                const double* a = reg(inst.a);
+                const int32_t exp = inst.b;
+                masked(mask, reg(inst.dst), [a, exp](size_t i) {
+                    return NTools::powInt(a[i], exp);
+                });
+                break;
+            }
+            case OpCode::Less:
+            {
+                const double *a = reg(inst.a), *b = reg(inst.b);
+                masked(mask, reg(inst.dst), [a, b](size_t i) {
+                    return (double) (a[i] < b[i]);
+                });
+                break;
+            }
+            case OpCode::LessEq:
+            {
+                const double *a = reg(inst.a), *b = reg(inst.b);
+                masked(mask, reg(inst.dst), [a, b](size_t i) {
+                    return (double) (a[i] <= b[i]);
+                });
+                break;
+            }
+            case OpCode::Greater:
+            {
+                const double *a = reg(inst.a), *b = reg(inst.b);
+                masked(mask, reg(inst.dst), [a, b](size_t i) {
+                    return (double) (a[i] > b[i]);
+                });
+                break;
+            }
+            case OpCode::GreaterEq:
+            {
+                const double *a = reg(inst.a), *b = reg(inst.b);
+                masked(mask, reg(inst.dst), [a, b](size_t i) {
+                    return (double) (a[i] >= b[i]);
+                });
+                break;
+            }
+            case OpCode::Equal:
+            {
+                const double *a = reg(inst.a), *b = reg(inst.b);
+                masked(mask, reg(inst.dst), [a, b](size_t i) {
+                    return (double) (a[i] == b[i]);
+                });
+                break;
+            }
+            case OpCode::NotEqual:
+            {
+                const double *a = reg(inst.a), *b = reg(inst.b);
+                masked(mask, reg(inst.dst), [a, b](size_t i) {
+                    return (double) (a[i] != b[i]);
+                });
+                break;
+            }
+            case OpCode::Truth:
+            {
+                const double* a = reg(inst.a);
+                masked(mask, reg(inst.dst), [a](size_t i) {
+                    return (double) (a[i] >= 0.5);
+                });
+                break;
+            }
+            case OpCode::Jump:
+                next = inst.dst;
+                break;
+            case OpCode::JumpIfFalse:
+            case OpCode::JumpIfTrue:
+            {
+                const double* a = reg(inst.a);
+                const bool jumpIf = inst.op == OpCode::JumpIfTrue;
+                size_t nJumped = 0;
+                for (size_t i = 0; i < n; i++) {
+                    nJumped += mask[i] && (a[i] >= 0.5) == jumpIf;
+                }
+                if (isUniform && (nJumped == 0 || nJumped == nRunning)) {
+                    next = nJumped == 0 ? pc + 1 : inst.dst;
+                    break;
+                }
+                for (size_t i = 0; i < n; i++) {
+                    if (mask[i]) {
+                        pcs[i] = (a[i] >= 0.5) == jumpIf ? inst.dst : pc + 1;
+                    }
+                }
+                isUniform = false;
+                continue;
+            }
+            case OpCode::Call:
+            {
+                const CallSite& site = arg_prog.calls[inst.b];
+                const Function& func = _eval._funcTable.at(site.func);
+                std::vector<const double*> args;
+                for (size_t arg = 0; arg < site.argNum; arg++) {
+                    args.emplace_back(reg(inst.a + arg));
+                }
+                std::vector<double> result;
+                if (func.batch) {
+                    std::vector<char> active(mask);
+                    result.assign(n, 0.);
+                    _scratch.clear();
+                    Profiler::Scope scope(_eval._profiler ? _eval._profiler->func(site.func) : nullptr, std::count(mask.begin(), mask.end(), true));
+                    func.batch(BatchArgs(n, args, active.data(), [this, &active](const std::string & arg_name) {
+                        return _var(arg_name, active.data());
+                    }), result.data());
+                    for (size_t i = 0; i < n; i++) {
+                        _dropped[i] = _dropped[i] || (mask[i] && !active[i]);
+                    }
+                } else if (func.body) {
+                    args.resize(std::min<size_t>(site.argNum, func.argNum));
+                    std::shared_ptr<const Program> body = func.body;
+                    result = _run(*body, args, mask);
+                } else {
+                    throw ASTReadError("Function cannot run column-wise. (" + _eval._funcs.name(site.func) + ")");
+                }
+                const double* src = result.data();
+                masked(mask, reg(inst.dst), [src](size_t i) {
+                    return src[i];
+                });
+                break;
+            }
+            case OpCode::Define:
+                throw ASTReadError("Functions cannot be defined column-wise.");
+        }
+        if (isUniform) {
+            pc = next - 1;
+            continue;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (mask[i]) {
+                pcs[i] = next;
+            }
+        }
+    }
+
+    if (arg_prog.code.empty()) {
+        return std::vector<double>(n, 0.);
+    }
+    return std::vector<double>(reg(arg_prog.result), reg(arg_prog.result) + n);
+}
+
+const double* ASTReader::ColumnEvaluator::_var(const std::string& arg_name, const char* arg_active) {
+    int32_t slot = _eval._vars.find(arg_name);
+    if (slot >= 0 && (size_t) slot < _columns.size() && !_columns[slot].empty()) {
+        if (_isStored[slot]) {
+            for (size_t i = 0; i < _size; i++) {
+                if (arg_active[i] && !_written[slot][i]) {
+                    throw ASTReadError(arg_name + " is used before it is set for the record.");
+                }
+            }
+        }
+        return _columns[slot].data();
+    }
+    if (slot < 0 || (size_t) slot >= _eval._isSet.size() || !_eval._isSet[slot]) {
+        throw ASTReadError("Constant not found. (" + arg_name + ")");
+    }
+    _scratch.emplace_back(_size, _eval._frame[slot]);
+    return _scratch.back().data();
+}
+
+void ASTReader::ColumnEvaluator::_retire(const std::vector<char>& arg_keep) {
+    for (const auto& slots : {&_recordSlots, &_storedSlots}) {
+        for (const auto& slot : *slots) {
+            std::vector<double>& column = _columns[slot];
+            std::vector<char>& written = _written[slot];
+            size_t pos = 0;
+            for (size_t i = 0; i < _size; i++) {
+                if (arg_keep[i]) {
+                    column[pos] = column[i];
+                    written[pos] = written[i];
+                    pos++;
+                } else if (written[i] && _index[i] + 1 > _last[slot].first) {
+                    _last[slot] = std::make_pair(_index[i] + 1, column[i]);
+                }
+            }
+        }
+    }
+    size_t nKept = 0;
+    for (size_t i = 0; i < _size; i++) {
+        if (arg_keep[i]) {
+            _index[nKept] = _index[i];
+            nKept++;
+        }
+    }
+    _size = nKept;
+}
+void ASTReader::ColumnEvaluator::_commit() {
+    _retire(std::vector<char>(_size, false));
+    for (const auto& slots : {&_recordSlots, &_storedSlots}) {
+        for (const auto& slot : *slots) {
+            if (_last[slot].first > 0) {
+                _eval._frame[slot] = _last[slot].second;
+                _eval._isSet[slot] = true;
+            }
+        }
+    }
+}
+
+void ASTReader::ColumnEvaluator::execute(const std::vector<const double*>& arg_columns, const size_t& arg_nRecords) {
+    if (!_progs) {
+        throw ASTReadError("ColumnEvaluator: Programs are not prepared.");
+    }
+    _columns.assign(_eval._frame.size(), std::vector<double>());
+    _written.assign(_eval._frame.size(), std::vector<char>());
+    for (size_t start = 0; start < arg_nRecords; start += chunkSize) {
+        _size = std::min(chunkSize, arg_nRecords - start);
+        for (size_t var = 0; var < _recordSlots.size(); var++) {
+            const int32_t& slot = _recordSlots[var];
+            _columns[slot].assign(arg_columns.at(var) + start, arg_columns.at(var) + start + _size);
+            _written[slot].assign(_size, true);
+        }
+        for (const auto& slot : _storedSlots) {
+            _columns[slot].assign(_size, _eval._isSet[slot] ? _eval._frame[slot] : std::nan(""));
+            _written[slot].assign(_size, false);
+        }
+        _index.resize(_size);
+        for (size_t i = 0; i < _size; i++) {
+            _index[i] = i;
+        }
+        _last.assign(_eval._frame.size(), std::make_pair(0, 0.));
+
+        // Records skipped by continue() are retired after each program so
+        // that the following ones only run over the remaining records.
+        for (const auto& prog : *_progs) {
+            if (_size == 0) {
+                break;
+            }
+            _dropped.assign(_size, false);
+            {
+                Profiler::Scope scope(_eval._profiler ? _eval._profiler->line(prog.line) : nullptr, _size);
+                _run(prog, std::vector<const double*>(), std::vector<char>(_size, true));
+            }
+            if (std::find(_dropped.begin(), _dropped.end(), true) != _dropped.end()) {
+                std::vector<char> keep(_size);
+                for (size_t i = 0; i < _size; i++) {
+                    keep[i] = !_dropped[i];
+                }
+                _retire(keep);
+            }
+        }
+        _commit();
+    }
+}
@@ -0,0 +1,194 @@
+/**
+ * @file compiler.cpp
+ * @brief AST to register bytecode compiler
+ * @date Created on: 2026/10/17, 10:12
+ */
+
+#include "include/compiler.h"
+#include "include/evaluator.h"
+
+int32_t ASTReader::Compiler::operator()(const double& arg_ast) {
+    int32_t dst = _alloc();
+    _prog.numbers.emplace_back(arg_ast);
+    _emit(OpCode::LoadNum, dst, _prog.numbers.size() - 1);
+    return dst;
+}
+
+int32_t ASTReader::Compiler::operator()(const AST::_Constant& arg_ast) {
+    int32_t dst = _alloc();
+    auto it_arg = _args.find(arg_ast);
+    if (it_arg != _args.end()) {
+        _emit(OpCode::Move, dst, it_arg->second);
+    } else {
+        _emit(OpCode::LoadVar, dst, _vars.intern(arg_ast));
+    }
+    return dst;
+}
+
+int32_t ASTReader::Compiler::operator()(const AST::_If& arg_ast) {
+    if (arg_ast.arguments.size() != 1 && arg_ast.arguments.size() != 2) {
+        throw ASTReadError("The if(...) directive should have two or three arguments.");
+    }
+    int32_t dst = boost::apply_visitor(*this, arg_ast.test);
+    size_t jumpElse = _emitJump(OpCode::JumpIfFalse, dst);
+    _next = dst;
+    boost::apply_visitor(*this, arg_ast.arguments.at(0));
+    size_t jumpEnd = _emitJump(OpCode::Jump, dst);
+    _patch(jumpElse);
+    _next = dst;
+    if (arg_ast.arguments.size() == 2) {
+        boost::apply_visitor(*this, arg_ast.arguments.at(1));
+    } else {
+        (*this)(0.);
+    }
+    _patch(jumpEnd);
+    return dst;
+}
+
+int32_t ASTReader::Compiler::operator()(const AST::_FuncCall& arg_ast) {
+    int32_t dst = _next;
+    for (const auto& elem : arg_ast.arguments) {
+        boost::apply_visitor(*this, elem);
+    }
+    _next = dst;
+    _alloc();
+    _prog.calls.push_back(CallSite{_funcs.intern(arg_ast.funcName), arg_ast.arguments.size()});
+    _emit(OpCode::Call, dst, dst, _prog.calls.size() - 1);
+    return dst;
+}
+
+int32_t ASTReader::Compiler::operator()(const AST::_Signed& arg_ast) {
+    int32_t dst = boost::apply_visitor(*this, arg_ast.primary);
+    if (arg_ast.sign < 0) {
+        _emit(OpCode::Neg, dst, dst);
+    }
+    return dst;
+}
+
+int32_t ASTReader::Compiler::operator()(const AST::_PowerUnary& arg_ast) {
+    int32_t dst = boost::apply_visitor(*this, arg_ast.base);
+    int32_t uexp = boost::apply_visitor(*this, arg_ast.uexp);
+    _emit(OpCode::Pow, dst, dst, uexp);
+    _next = dst + 1;
+    return dst;
+}
+
+int32_t ASTReader::Compiler::operator()(const AST::_PowerInt& arg_ast) {
+    int32_t dst = boost::apply_visitor(*this, arg_ast.base);
+    _emit(OpCode::PowInt, dst, dst, arg_ast.iexp);
+    return dst;
+}
+
+int32_t ASTReader::Compiler::operator()(const AST::_Times& arg_ast) {
+    int32_t dst = boost::apply_visitor(*this, arg_ast.first);
+    for (const auto& elem : arg_ast.rest) {
+        int32_t operand = boost::apply_visitor(*this, elem.operand);
+        _emit(elem.invert ? OpCode::Div : OpCode::Mul, dst, dst, operand);
+        _next = dst + 1;
+    }
+    return dst;
+}
+
+int32_t ASTReader::Compiler::operator()(const AST::_Plus& arg_ast) {
+    int32_t dst = _next;
+    bool isFirst = true;
+    for (const auto& elem : arg_ast) {
+        int32_t operand = boost::apply_visitor(*this, elem);
+        if (isFirst) {
+            isFirst = false;
+        } else {
+            _emit(OpCode::Add, dst, dst, operand);
+            _next = dst + 1;
+        }
+    }
+    if (isFirst) {
+        (*this)(0.);
+    }
+    return dst;
+}
+
+int32_t ASTReader::Compiler::operator()(const AST::_Relational& arg_ast) {
+    int32_t dst = boost::apply_visitor(*this, arg_ast.first);
+    int32_t rhs = boost::apply_visitor(*this, arg_ast.rest.operand);
+    const std::string& op = arg_ast.rest.operation;
+    OpCode code;
+    if (op == "<") {
+        code = OpCode::Less;
+    } else if (op == "<=") {
+        code = OpCode::LessEq;
+    } else if (op == ">") {
+        code = OpCode::Greater;
+    } else if (op == ">=") {
+        code = OpCode::GreaterEq;
+    } else if (op == "==") {
+        code = OpCode::Equal;
+    } else if (op == "!=") {
+        code = OpCode::NotEqual;
+    } else {
+        throw ASTReadError("Unknown relational operator. (" + op + ")");
+    }
+    _emit(code, dst, dst, rhs);
+    _next = dst + 1;
+    return dst;
+}
+
+int32_t ASTReader::Compiler::operator()(const AST::_AndRel& arg_ast) {
+    int32_t dst = _next;
+    std::vector<size_t> jumpEnd;
+    bool isFirst = true;
+    for (const auto& elem : arg_ast) {
+        if (isFirst) {
+            isFirst = false;
+        } else {
+            jumpEnd.emplace_back(_emitJump(OpCode::JumpIfFalse, dst));
+        }
+        _next = dst;
+        boost::apply_visitor(*this, elem);
+        _emit(OpCode::Truth, dst, dst);
+    }
+    for (const auto& pos : jumpEnd) {
+        _patch(pos);
+    }
+    return dst;
+}
+
+int32_t ASTReader::Compiler::operator()(const AST::_OrRel& arg_ast) {
+    int32_t dst = _next;
+    std::vector<size_t> jumpEnd;
+    bool isFirst = true;
+    for (const auto& elem : arg_ast) {
+        if (isFirst) {
+            isFirst = false;
+        } else {
+            jumpEnd.emplace_back(_emitJump(OpCode::JumpIfTrue, dst));
+        }
+        _next = dst;
+        boost::apply_visitor(*this, elem);
+        _emit(OpCode::Truth, dst, dst);
+    }
+    for (const auto& pos : jumpEnd) {
+        _patch(pos);
+    }
+    return dst;
+}
+
+int32_t ASTReader::Compiler::operator()(const AST::_Substitute& arg_ast) {
+    int32_t dst = boost::apply_visitor(*this, arg_ast.val);
+    for (const auto& elem : arg_ast.cName) {
+        auto it_arg = _args.find(elem);
+        if (it_arg != _args.end()) {
+            _emit(OpCode::Move, it_arg->second, dst);
+        } else {
+            _emit(OpCode::StoreVar, dst, _vars.intern(elem));
+        }
+    }
+    return dst;
+}
+
+int32_t ASTReader::Compiler::operator()(const AST::_FuncDef& arg_ast) {
+    _prog.defs.push_back(FuncDefinition{_funcs.intern(arg_ast.fName.fName), arg_ast.fName.fArgs.size(),
+        std::make_shared<const Program>(compile(arg_ast.expr, _vars, _funcs, arg_ast.fName.fArgs))});
+    int32_t dst = _alloc();
+    _emit(OpCode::Define, dst, _prog.defs.size() - 1);
+    return dst;
+}
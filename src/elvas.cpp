@@ -7,7 +7,9 @@
 #include "include/version.h"
 #include "include/elvas.h"
 #include "include/ntools.h"
+#include "include/cheb_table.h"
 #include <iostream>
+#include <memory>
 
 #ifdef _WIN32
 #define NOMINMAX 1
@@ -17,15 +19,37 @@
 #include <unistd.h>
 #endif
 
-double Elvas::lnPhiC2LnRinv(const double& arg_lnPhiC, std::vector<std::pair<double, double>>&arg_lnPhiC2lnRinv) {
+const std::vector<std::pair<double, double>>& Elvas::Table::sortedByFirst() {
+    if (!_isSortedFirst) {
+        std::sort(_data.begin(), _data.end(), [](const std::pair<double, double>& a, const std::pair<double, double>& b) {
+            return a.first < b.first;
+        });
+        _isSortedFirst = true;
+        _isSortedSecond = std::is_sorted(_data.begin(), _data.end(), [](const std::pair<double, double>& a, const std::pair<double, double>& b) {
+            return a.second < b.second;
+        });
+    }
+    return _data;
+}
+
+const std::vector<std::pair<double, double>>& Elvas::Table::sortedBySecond() {
+    if (!_isSortedSecond) {
+        std::sort(_data.begin(), _data.end(), [](const std::pair<double, double>& a, const std::pair<double, double>& b) {
+            return a.second < b.second;
+        });
+        _isSortedSecond = true;
+        _isSortedFirst = std::is_sorted(_data.begin(), _data.end(), [](const std::pair<double, double>& a, const std::pair<double, double>& b) {
+            return a.first < b.first;
+        });
+    }
+    return _data;
+}
+
+double Elvas::lnPhiC2LnRinv(const double& arg_lnPhiC, const std::vector<std::pair<double, double>>&arg_lnPhiC2lnRinv) {
     if (arg_lnPhiC2lnRinv.size() < 3) {
         throw ElvasError("lnPhiC2LnRinv: Data size is too small.");
     }
 
-    std::sort(arg_lnPhiC2lnRinv.begin(), arg_lnPhiC2lnRinv.end(), [](std::pair<double, double>& a, std::pair<double, double>& b) {
-        return a.second < b.second;
-    });
-
     auto it_lnPhiC2lnRinv = arg_lnPhiC2lnRinv.begin();
     while (it_lnPhiC2lnRinv != arg_lnPhiC2lnRinv.end() - 1) {
         if (it_lnPhiC2lnRinv->first < (it_lnPhiC2lnRinv + 1)->first) {
@@ -43,7 +67,7 @@ double Elvas::lnPhiC2LnRinv(const double& arg_lnPhiC, std::vector<std::pair<doub
     return NTools::interpolateL2(it_lnPhiC2lnRinv, arg_lnPhiC2lnRinv.end(), arg_lnPhiC);
 }
 
-double Elvas::getLnGamma(std::vector<std::pair<double, double>>&arg_lndgam, const double& arg_lnRinvBeg, const double& arg_lnRinvEnd) {
+double Elvas::getLnGamma(const std::vector<std::pair<double, double>>&arg_lndgam, const double& arg_lnRinvBeg, const double& arg_lnRinvEnd) {
     if (arg_lndgam.size() < 3) {
         throw ElvasError("getLnGamma: Data size is too small.");
     }
@@ -51,26 +75,122 @@ double Elvas::getLnGamma(std::vector<std::pair<double, double>>&arg_lndgam, cons
         throw ElvasError("getLnGamma: Invalid region of integration.");
     }
 
-    std::sort(arg_lndgam.begin(), arg_lndgam.end(), [](std::pair<double, double>& a, std::pair<double, double>& b) {
-        return a.first < b.first;
-    });
-
     auto it_max = std::max_element(arg_lndgam.begin(), arg_lndgam.end(), [](const std::pair<double, double>& a, const std::pair<double, double>& b) {
         return a.second < b.second;
     });
-    double& lndgamMax = it_max->second;
+    const double& lndgamMax = it_max->second;
 
     double dlnRinv = (arg_lnRinvEnd - arg_lnRinvBeg) / (nInteg - 1.);
 
     std::vector<double> dgamma(nInteg);
+    auto lndgam = NTools::cursorL2(arg_lndgam.begin(), arg_lndgam.end());
     int i;
     for (i = 0; i < nInteg; i++) {
-        dgamma.at(i) = exp(NTools::interpolateL2(arg_lndgam.begin(), arg_lndgam.end(), arg_lnRinvBeg + dlnRinv * i, true) - lndgamMax);
+        dgamma.at(i) = exp(lndgam(arg_lnRinvBeg + dlnRinv * i) - lndgamMax);
     }
 
     return lndgamMax + log(NTools::integrateSIMP(dgamma.begin(), dgamma.end(), dlnRinv, NTools::SIMPSON_LAST));
 }
 
+double Elvas::getLnGamma(const std::vector<std::pair<double, double>>&arg_lndgam, const double& arg_lnRinvBeg, const double& arg_lnRinvEnd,
+        const double& arg_tol, size_t& arg_nEval, double& arg_error) {
+    if (arg_lndgam.size() < 3) {
+        throw ElvasError("getLnGamma: Data size is too small.");
+    }
+    if (arg_lnRinvBeg >= arg_lnRinvEnd) {
+        throw ElvasError("getLnGamma: Invalid region of integration.");
+    }
+    if (!(arg_tol > 0.)) {
+        throw ElvasError("getLnGamma: Tolerance should be positive.");
+    }
+
+    auto it_max = std::max_element(arg_lndgam.begin(), arg_lndgam.end(), [](const std::pair<double, double>& a, const std::pair<double, double>& b) {
+        return a.second < b.second;
+    });
+    const double& lndgamMax = it_max->second;
+
+    auto lndgam = NTools::cursorL2(arg_lndgam.begin(), arg_lndgam.end());
+    double gamma = NTools::integrateAdaptiveSIMP([&lndgam, &lndgamMax](const double& arg_lnRinv) {
+        return exp(lndgam(arg_lnRinv) - lndgamMax);
+    }, arg_lnRinvBeg, arg_lnRinvEnd, arg_tol, arg_nEval, arg_error);
+    arg_error /= gamma;
+
+    return lndgamMax + log(gamma);
+}
+
+namespace {
+    // The parts of the quantum corrections above the thresholds of the
+    // expansions in x that depend on x alone.
+
+    double scalarLarge(const double& arg_x) {
+        double x = arg_x;
+        double x2 = x * x;
+        double x3 = x * x2;
+        double x4 = x * x3;
+        return -0.0261559272783723 + 0.0000886704923163256 / x4
+                + 0.0000962000962000962 / x3 + 0.000198412698412698 / x2
+                + 0.00105820105820106 / x + 0.111111111111111 * x
+                - 0.181204187497805 * x2 + (-0.0055555555555556
+                + 0.166666666666667 * x2) * log(x);
+    }
+
+    double fermionLarge(const double& arg_x) {
+        double x = arg_x;
+        double x2 = x * x;
+        double x3 = x * x2;
+        return -0.227732960077634 + 0.00260942760942761 / x3
+                + 0.00271164021164021 / x2 + 0.00820105820105820 / x
+                + 0.53790187962670 * x + 0.296728717591129 * x2
+                + (-0.06111111111111111 - 0.3333333333333333 * x
+                - 0.1666666666666666 * x2) * log(x);
+    }
+
+    double gaugeLarge(const double& arg_x) {
+        double x = arg_x;
+        double x2 = x * x;
+        double x3 = x * x2;
+        double x4 = x * x3;
+        double sqrt_x = sqrt(x);
+        double x3_2 = x * sqrt_x;
+        double x5_2 = x * x3_2;
+        double x7_2 = x * x5_2;
+        return -0.580011057371274 + 0.000482461693399193 / x4 - 0.0000211853167446059 / x7_2
+                + 0.000685425685425685 / x3 - 0.000271172054330955 / x5_2 + 0.00218253968253968 / x2
+                - 0.00433875286929528 / x3_2 + 0.0198412698412698 / x - 0.138840091817449 / sqrt_x
+                + 2.22144146907918 * sqrt_x - 1.58722512498683 * x - 0.210279229160082 * x2
+                + (-0.183333333333333 + x + 0.5 * x2) * log(x)
+                + 0.5 * log(x / cosh(8.47412669784234e-6 / x7_2 * 
+                    (5. + 64. * x + 1024. * x2 + 32768. * x3 - 524288. * x4)));
+    }
+
+    // Table of gaugeLarge, if selected by Elvas::setKernels. It covers x
+    // below 2^14, where the cosh is still finite. scalarLarge and
+    // fermionLarge are cheap enough that tables of them gain nothing.
+    std::unique_ptr<const ChebTable> gaugeTable;
+    char kernels = 'C';
+}
+
+void Elvas::setKernels(const char& arg_kernels) {
+    if (arg_kernels == 'C') {
+        gaugeTable.reset();
+    } else if (arg_kernels == 'T') {
+        if (!gaugeTable) {
+            gaugeTable.reset(new ChebTable(gaugeLarge, 0, 14, 3, 8));
+        }
+    } else {
+        throw ElvasError("Elvas: Unknown kernels. (" + std::string(1, arg_kernels) + ")");
+    }
+    kernels = arg_kernels;
+}
+
+char Elvas::getKernels() {
+    return kernels;
+}
+
+double Elvas::tableError() {
+    return gaugeTable ? gaugeTable->maxError() : 0.;
+}
+
 double Elvas::scalarQC(const double& arg_kappa, const double& arg_lambdaAbs, const double& arg_lnQR) {
     double temp;
     double x = arg_kappa / arg_lambdaAbs;
@@ -90,11 +210,7 @@ double Elvas::scalarQC(const double& arg_kappa, const double& arg_lambdaAbs, con
                 - 0.0625481711576628 * x8 + 0.0555697470602515 * x9
                 - 0.0500042455037409 * x10 - 0.333333333333333 * x2 * arg_lnQR;
     } else {
-        temp = -0.0261559272783723 + 0.0000886704923163256 / x4
-                + 0.0000962000962000962 / x3 + 0.000198412698412698 / x2
-                + 0.00105820105820106 / x + 0.111111111111111 * x
-                - 0.181204187497805 * x2 + (-0.0055555555555556
-                + 0.166666666666667 * x2) * log(x) - 0.333333333333333 * x2 * arg_lnQR;
+        temp = scalarLarge(x) - 0.333333333333333 * x2 * arg_lnQR;
     }
     return temp;
 }
@@ -116,11 +232,7 @@ double Elvas::fermionQC(const double& arg_y, const double& arg_lambdaAbs, const
                 - 0.0000353785958610453 * x7 + 7.67709260595572e-6 * x8
                 + (0.66666666666667 * x + 0.333333333333333 * x2) * arg_lnQR;
     } else {
-        temp = -0.227732960077634 + 0.00260942760942761 / x3
-                + 0.00271164021164021 / x2 + 0.00820105820105820 / x
-                + 0.53790187962670 * x + 0.296728717591129 * x2
-                + (-0.06111111111111111 - 0.3333333333333333 * x
-                - 0.1666666666666666 * x2) * log(x)
+        temp = fermionLarge(x)
                 + (0.66666666666667 * x + 0.333333333333333 * x2) * arg_lnQR;
     }
     return temp;
@@ -144,23 +256,129 @@ double Elvas::gaugeQC(const double& arg_gSquared, const double& arg_lambdaAbs, c
                 + 0.5 * log(arg_lambdaAbs)
                 + (-0.333333333333333 - 2. * x -  x2) * arg_lnQR;
     } else {
-        double sqrt_x = sqrt(x);
-        double x3_2 = x * sqrt_x;
-        double x5_2 = x * x3_2;
-        double x7_2 = x * x5_2;
-        temp = -0.580011057371274 + 0.000482461693399193 / x4 - 0.0000211853167446059 / x7_2
-                + 0.000685425685425685 / x3 - 0.000271172054330955 / x5_2 + 0.00218253968253968 / x2
-                - 0.00433875286929528 / x3_2 + 0.0198412698412698 / x - 0.138840091817449 / sqrt_x
-                + 2.22144146907918 * sqrt_x - 1.58722512498683 * x - 0.210279229160082 * x2
-                + (-0.183333333333333 + x + 0.5 * x2) * log(x)
-                + 0.5 * log(x / cosh(8.47412669784234e-6 / x7_2 * 
-                    (5. + 64. * x + 1024. * x2 + 32768. * x3 - 524288. * x4)))
+        temp = (gaugeTable && gaugeTable->covers(x) ? (*gaugeTable)(x) : gaugeLarge(x))
                 + 0.5 * log(arg_lambdaAbs)
                 - (0.333333333333333 + 2. * x + x2) * arg_lnQR;
     }
     return temp;
 }
 
+void Elvas::instantonB(const double* arg_lambdaAbs, double* arg_out, const size_t& arg_n) {
+    for (size_t i = 0; i < arg_n; i++) {
+        arg_out[i] = 26.3189450695716 / arg_lambdaAbs[i];
+    }
+}
+
+void Elvas::higgsQC(const double* arg_lambdaAbs, const double* arg_lnQR, double* arg_out, const size_t& arg_n) {
+    for (size_t i = 0; i < arg_n; i++) {
+        arg_out[i] = -0.99192944327027 + 2.5 * NTools::vecLog(arg_lambdaAbs[i]) - 3. * arg_lnQR[i];
+    }
+}
+
+void Elvas::scalarQC(const double* arg_kappa, const double* arg_lambdaAbs, const double* arg_lnQR, double* arg_out, const size_t& arg_n) {
+    for (size_t i = 0; i < arg_n; i++) {
+        double x = arg_kappa[i] / arg_lambdaAbs[i];
+        double x2 = x * x;
+        double lnQR = arg_lnQR[i];
+        double low = x2 * (-0.239133939224974 + x * (0.222222222222222
+                + x * (-0.134704602106396 + x * (0.102278606592866
+                + x * (-0.0839329261179402 + x * (0.0715956882048009
+                + x * (-0.0625481711576628 + x * (0.0555697470602515
+                + x * -0.0500042455037409))))))) - 0.333333333333333 * lnQR);
+        double y = 1. / x;
+        double high = -0.0261559272783723
+                + y * (0.00105820105820106 + y * (0.000198412698412698
+                + y * (0.0000962000962000962 + y * 0.0000886704923163256)))
+                + 0.111111111111111 * x - 0.181204187497805 * x2
+                + (-0.0055555555555556 + 0.166666666666667 * x2) * NTools::vecLog(x) - 0.333333333333333 * x2 * lnQR;
+        arg_out[i] = x < 0.7 ? low : high;
+    }
+}
+
+void Elvas::fermionQC(const double* arg_y, const double* arg_lambdaAbs, const double* arg_lnQR, double* arg_out, const size_t& arg_n) {
+    for (size_t i = 0; i < arg_n; i++) {
+        double x = arg_y[i] * arg_y[i] / arg_lambdaAbs[i];
+        double x2 = x * x;
+        double lnQR = (0.66666666666667 * x + 0.333333333333333 * x2) * arg_lnQR[i];
+        double low = x * (0.64493454511661 + x * (0.005114971505109
+                + x * (-0.0366953662258276 + x * (0.00476307962690785
+                + x * (-0.000845451274112082 + x * (0.000168244913551417
+                + x * (-0.0000353785958610453 + x * 7.67709260595572e-6)))))));
+        double y = 1. / x;
+        double high = -0.227732960077634
+                + y * (0.00820105820105820 + y * (0.00271164021164021 + y * 0.00260942760942761))
+                + 0.53790187962670 * x + 0.296728717591129 * x2
+                + (-0.06111111111111111 - 0.3333333333333333 * x
+                - 0.1666666666666666 * x2) * NTools::vecLog(x);
+        arg_out[i] = (x < 1.3 ? low : high) + lnQR;
+    }
+}
+
+void Elvas::gaugeQC(const double* arg_gSquared, const double* arg_lambdaAbs, const double* arg_lnQR, double* arg_out, const size_t& arg_n) {
+    if (kernels == 'T') {
+        for (size_t i = 0; i < arg_n; i++) {
+            arg_out[i] = gaugeQC(arg_gSquared[i], arg_lambdaAbs[i], arg_lnQR[i]);
+        }
+        return;
+    }
+    for (size_t i = 0; i < arg_n; i++) {
+        double x = arg_gSquared[i] / arg_lambdaAbs[i];
+        double x2 = x * x;
+        double common = 0.5 * NTools::vecLog(arg_lambdaAbs[i]) - (0.333333333333333 + 2. * x + x2) * arg_lnQR[i];
+        double low = -0.966861032843734 + x * (-1.76813696868318 + x * (0.61593151565841
+                + x * (0.127848258241082 + x * (-0.0205690315959429
+                + x * (0.00467728575401191 + x * (-0.00121386963701736
+                + x * (0.000336192073844430 + x * -0.0000966171446396430)))))));
+        double sqrt_x = sqrt(x);
+        double y = 1. / sqrt_x;
+        double y2 = y * y;
+        double y3 = y * y2;
+        double y7 = y3 * y3 * y;
+        double ln_x = NTools::vecLog(x);
+        double z = 8.47412669784234e-6 * y7 * (5. + 64. * x + 1024. * x2 + 32768. * x2 * x - 524288. * x2 * x2);
+        double e_z = NTools::vecExp(z);
+        double high = -0.580011057371274
+                + y2 * (0.0198412698412698 + y2 * (0.00218253968253968
+                + y2 * (0.000685425685425685 + y2 * 0.000482461693399193)))
+                + y * (-0.138840091817449 + y2 * (-0.00433875286929528
+                + y2 * (-0.000271172054330955 + y2 * -0.0000211853167446059)))
+                + 2.22144146907918 * sqrt_x - 1.58722512498683 * x - 0.210279229160082 * x2
+                + (-0.183333333333333 + x + 0.5 * x2) * ln_x
+                + 0.5 * (ln_x - NTools::vecLog(0.5 * (e_z + 1. / e_z)));
+        arg_out[i] = (x < 1.1 ? low : high) + common;
+    }
+}
+
+void Elvas::smBeta(const double* arg_couplings, double* arg_beta) {
+    const double g1 = arg_couplings[0], g2 = arg_couplings[1], g3 = arg_couplings[2];
+    const double yt = arg_couplings[3], yb = arg_couplings[4], lambda = arg_couplings[5];
+    const double g1s = g1 * g1, g2s = g2 * g2, g3s = g3 * g3, yts = yt * yt, ybs = yb * yb, lambdas = lambda * lambda;
+    const double loop = 1. / (16. * M_PI * M_PI), loop2 = loop * loop;
+
+    arg_beta[0] = g1 * g1s * (loop * 41. / 10.
+            + loop2 * (199. / 50. * g1s + 27. / 10. * g2s + 44. / 5. * g3s - 17. / 10. * yts - 1. / 2. * ybs));
+    arg_beta[1] = g2 * g2s * (-loop * 19. / 6.
+            + loop2 * (9. / 10. * g1s + 35. / 6. * g2s + 12. * g3s - 3. / 2. * yts - 3. / 2. * ybs));
+    arg_beta[2] = g3 * g3s * (-loop * 7.
+            + loop2 * (11. / 10. * g1s + 9. / 2. * g2s - 26. * g3s - 2. * yts - 2. * ybs));
+
+    arg_beta[3] = yt * (loop * (9. / 2. * yts + 3. / 2. * ybs - 17. / 20. * g1s - 9. / 4. * g2s - 8. * g3s)
+            + loop2 * (-12. * yts * yts + yts * (393. / 80. * g1s + 225. / 16. * g2s + 36. * g3s - 12. * lambda)
+            + 6. * lambdas - 108. * g3s * g3s + 9. * g2s * g3s + 19. / 15. * g1s * g3s
+            - 23. / 4. * g2s * g2s - 9. / 20. * g1s * g2s + 1187. / 600. * g1s * g1s));
+    arg_beta[4] = yb * loop * (9. / 2. * ybs + 3. / 2. * yts - 1. / 4. * g1s - 9. / 4. * g2s - 8. * g3s);
+
+    arg_beta[5] = loop * (24. * lambdas + lambda * (12. * yts + 12. * ybs - 9. * g2s - 9. / 5. * g1s)
+            - 6. * yts * yts - 6. * ybs * ybs + 3. / 8. * (2. * g2s * g2s + std::pow(g2s + 3. / 5. * g1s, 2)))
+            + loop2 * (-312. * lambdas * lambda - 144. * lambdas * yts - 3. * lambda * yts * yts + 30. * yts * yts * yts
+            - 32. * g3s * yts * yts + 80. * lambda * g3s * yts + lambdas * (108. * g2s + 108. / 5. * g1s)
+            + lambda * yts * (45. / 2. * g2s + 17. / 2. * g1s) - 8. / 5. * g1s * yts * yts
+            - yts * (9. / 4. * g2s * g2s - 63. / 10. * g1s * g2s + 171. / 100. * g1s * g1s)
+            - lambda * (73. / 8. * g2s * g2s - 117. / 20. * g1s * g2s - 1887. / 200. * g1s * g1s)
+            + 305. / 16. * g2s * g2s * g2s - 289. / 80. * g1s * g2s * g2s - 1677. / 400. * g1s * g1s * g2s
+            - 3411. / 2000. * g1s * g1s * g1s);
+}
+
 Elvas::PrintBox::PrintBox(std::ostream& arg_out) : _out(arg_out) {
 #ifdef _WIN32
     CONSOLE_SCREEN_BUFFER_INFO info;
@@ -0,0 +1,45 @@
+/**
+ * @file elvas_model.cpp
+ * @brief Embedding API of ELVAS
+ * @date Created on: 2026/10/17, 21:20
+ */
+
+#include "include/elvas_model.h"
+#include <fstream>
+
+ElvasModel::ElvasModel(const std::string& arg_script) : _is(arg_script), _script(_is, _os) {
+    _script.setPrintSink([ this ](const ASTReader::ArgSpan& arg_x) {
+        _printed.emplace_back(arg_x.begin(), arg_x.end());
+    });
+    _script.load();
+}
+
+std::string ElvasModel::readFile(const std::string& arg_path) {
+    std::ifstream ifs(arg_path);
+    if (!ifs) {
+        throw std::runtime_error("File open error. (" + arg_path + ")");
+    }
+    std::ostringstream oss;
+    oss << ifs.rdbuf();
+    return oss.str();
+}
+
+const std::vector<std::vector<double>>& ElvasModel::run(const std::vector<double>& arg_datasetVals, const double* arg_records, const size_t& arg_nRecords) {
+    _printed.clear();
+    _script.runDataset(arg_datasetVals, arg_records, arg_nRecords);
+    return _printed;
+}
+
+const std::vector<std::vector<double>>& ElvasModel::run(const std::vector<double>& arg_datasetVals, const std::vector<double>& arg_records) {
+    const size_t nVars = _script.recordVarNames().size();
+    if (nVars == 0 || arg_records.size() % nVars != 0) {
+        throw Interpreter::InterpreterError("Data format error.");
+    }
+    return run(arg_datasetVals, arg_records.data(), arg_records.size() / nVars);
+}
+
+const std::vector<std::vector<double>>& ElvasModel::finalize() {
+    _printed.clear();
+    _script.finalize();
+    return _printed;
+}
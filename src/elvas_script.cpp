@@ -10,97 +10,215 @@
 
 ElvasScript::ElvasScript(std::istream& arg_is, std::ostream& arg_os) : Interpreter(arg_is, arg_os) {
     arg_os << std::scientific;
-    auto InstantonB = [ this ](const std::vector<double>& arg_x) {
-        return Elvas::instantonB(-_eval("HIGGS_QUARTIC_COUPLING"));
+    _slots.lambda = _eval.getSlot("HIGGS_QUARTIC_COUPLING");
+    _slots.lnQR = _eval.getSlot("LN_QR");
+    _slots.lnRinv = _eval.getSlot("LN_RINV");
+    _slots.lnGammaEvals = _eval.getSlot("LNGAMMA_EVALS");
+    _slots.lnGammaError = _eval.getSlot("LNGAMMA_ERROR");
+
+    auto InstantonB = [ this ](const ASTReader::ArgSpan& arg_x) {
+        return Elvas::instantonB(-_eval.load(_slots.lambda));
+    };
+
+    auto HiggsQC = [ this ](const ASTReader::ArgSpan& arg_x) {
+        return Elvas::higgsQC(-_eval.load(_slots.lambda), _eval.load(_slots.lnQR));
+    };
+
+    auto ScalarQC = [ this ](const ASTReader::ArgSpan& arg_x) {
+        return Elvas::scalarQC(arg_x.at(0), -_eval.load(_slots.lambda), _eval.load(_slots.lnQR));
+    };
+
+    auto FermionQC = [ this ](const ASTReader::ArgSpan& arg_x) {
+        return Elvas::fermionQC(arg_x.at(0), -_eval.load(_slots.lambda), _eval.load(_slots.lnQR));
+    };
+
+    auto GaugeQC = [ this ](const ASTReader::ArgSpan& arg_x) {
+        return Elvas::gaugeQC(arg_x.at(0), -_eval.load(_slots.lambda), _eval.load(_slots.lnQR));
+    };
+
+    auto lambdaAbsBatch = [](const ASTReader::BatchArgs& arg_x) {
+        const double* lambda = arg_x.var("HIGGS_QUARTIC_COUPLING");
+        std::vector<double> lambdaAbs(arg_x.size());
+        for (size_t i = 0; i < lambdaAbs.size(); i++) {
+            lambdaAbs[i] = -lambda[i];
+        }
+        return lambdaAbs;
+    };
+
+    auto InstantonBBatch = [ lambdaAbsBatch ](const ASTReader::BatchArgs& arg_x, double* arg_result) {
+        Elvas::instantonB(lambdaAbsBatch(arg_x).data(), arg_result, arg_x.size());
     };
 
-    auto HiggsQC = [ this ](const std::vector<double>& arg_x) {
-        return Elvas::higgsQC(-_eval("HIGGS_QUARTIC_COUPLING"), _eval("LN_QR"));
+    auto HiggsQCBatch = [ lambdaAbsBatch ](const ASTReader::BatchArgs& arg_x, double* arg_result) {
+        Elvas::higgsQC(lambdaAbsBatch(arg_x).data(), arg_x.var("LN_QR"), arg_result, arg_x.size());
     };
 
-    auto ScalarQC = [ this ](const std::vector<double>& arg_x) {
-        return Elvas::scalarQC(arg_x.at(0), -_eval("HIGGS_QUARTIC_COUPLING"), _eval("LN_QR"));
+    auto ScalarQCBatch = [ lambdaAbsBatch ](const ASTReader::BatchArgs& arg_x, double* arg_result) {
+        Elvas::scalarQC(arg_x.at(0), lambdaAbsBatch(arg_x).data(), arg_x.var("LN_QR"), arg_result, arg_x.size());
     };
 
-    auto FermionQC = [ this ](const std::vector<double>& arg_x) {
-        return Elvas::fermionQC(arg_x.at(0), -_eval("HIGGS_QUARTIC_COUPLING"), _eval("LN_QR"));
+    auto FermionQCBatch = [ lambdaAbsBatch ](const ASTReader::BatchArgs& arg_x, double* arg_result) {
+        Elvas::fermionQC(arg_x.at(0), lambdaAbsBatch(arg_x).data(), arg_x.var("LN_QR"), arg_result, arg_x.size());
     };
 
-    auto GaugeQC = [ this ](const std::vector<double>& arg_x) {
-        return Elvas::gaugeQC(arg_x.at(0), -_eval("HIGGS_QUARTIC_COUPLING"), _eval("LN_QR"));
+    auto GaugeQCBatch = [ lambdaAbsBatch ](const ASTReader::BatchArgs& arg_x, double* arg_result) {
+        Elvas::gaugeQC(arg_x.at(0), lambdaAbsBatch(arg_x).data(), arg_x.var("LN_QR"), arg_result, arg_x.size());
     };
 
-    auto saveLnDGamma = [ this ](const std::vector<double>& arg_x) {
-        _lndgamma.emplace_back(_eval("LN_RINV"), arg_x.at(0));
+    auto saveLnDGamma = [ this ](const ASTReader::ArgSpan& arg_x) {
+        _lndgamma.emplace_back(_eval.load(_slots.lnRinv), arg_x.at(0));
         return 0.;
     };
 
-    auto saveLnPhiC = [ this ](const std::vector<double>& arg_x) {
-        const double&lambda = _eval("HIGGS_QUARTIC_COUPLING"), &lnRinv = _eval("LN_RINV");
+    auto saveLnPhiC = [ this ](const ASTReader::ArgSpan& arg_x) {
+        const double lambda = _eval.load(_slots.lambda), lnRinv = _eval.load(_slots.lnRinv);
         _lnPhiC.emplace_back(lnRinv + .5 * log(8.) - .5 * log(-lambda), lnRinv);
         return 0.;
     };
 
-    auto initialize = [ this ](const std::vector<double>& arg_x) {
+    auto saveLnDGammaBatch = [ this ](const ASTReader::BatchArgs& arg_x, double* arg_result) {
+        const double* lnRinv = arg_x.var("LN_RINV");
+        const double* lndgamma = arg_x.at(0);
+        for (size_t i = 0; i < arg_x.size(); i++) {
+            if (arg_x.active()[i]) {
+                _lndgamma.emplace_back(lnRinv[i], lndgamma[i]);
+            }
+            arg_result[i] = 0.;
+        }
+    };
+
+    auto saveLnPhiCBatch = [ this ](const ASTReader::BatchArgs& arg_x, double* arg_result) {
+        const double* lambda = arg_x.var("HIGGS_QUARTIC_COUPLING");
+        const double* lnRinv = arg_x.var("LN_RINV");
+        for (size_t i = 0; i < arg_x.size(); i++) {
+            if (arg_x.active()[i]) {
+                _lnPhiC.emplace_back(lnRinv[i] + .5 * log(8.) - .5 * log(-lambda[i]), lnRinv[i]);
+            }
+            arg_result[i] = 0.;
+        }
+    };
+
+    auto initialize = [ this ](const ASTReader::ArgSpan& arg_x) {
         _lnPhiC.clear();
         _lndgamma.clear();
         return 0.;
     };
 
-    auto checkSize = [ this ](const std::vector<double>& arg_x) {
+    auto checkSize = [ this ](const ASTReader::ArgSpan& arg_x) {
         return _lndgamma.size() >= 3;
     };
 
-    auto getMaxLnRinv = [ this ](const std::vector<double>& arg_x) {
+    auto getMaxLnRinv = [ this ](const ASTReader::ArgSpan& arg_x) {
         if (_lndgamma.size() < 3) {
             throw EScriptError("get_max_lnRinv: Too small data size.");
         }
-        auto it_max = std::max_element(_lndgamma.begin(), _lndgamma.end(), [](const auto& a, const auto& b) {
-            return a.first < b.first;
-        });
-        double temp = it_max->first;
+        double temp = _lndgamma.sortedByFirst().back().first;
         try {
-            temp = std::min(temp, Elvas::lnPhiC2LnRinv(arg_x.front(), _lnPhiC));
+            temp = std::min(temp, Elvas::lnPhiC2LnRinv(arg_x.front(), _lnPhiC.sortedBySecond()));
         } catch (const Elvas::ElvasError& arg_e) {
         }
         return std::min(temp, arg_x.front());
     };
 
-    auto getMinLnRinv = [ this ](const std::vector<double>& arg_x) {
+    auto getMinLnRinv = [ this ](const ASTReader::ArgSpan& arg_x) {
         if (_lndgamma.size() < 3) {
             throw EScriptError("get_min_lnRinv: Too small data size.");
         }
-        auto it_min = std::min_element(_lndgamma.begin(), _lndgamma.end(), [](const auto& a, const auto& b) {
-            return a.first < b.first;
-        });
-        double temp = it_min->first;
+        double temp = _lndgamma.sortedByFirst().front().first;
         try {
-            temp = std::max(temp, Elvas::lnPhiC2LnRinv(arg_x.front(), _lnPhiC));
+            temp = std::max(temp, Elvas::lnPhiC2LnRinv(arg_x.front(), _lnPhiC.sortedBySecond()));
         } catch (const Elvas::ElvasError& arg_e) {
         }
         return std::max(temp, arg_x.front());
     };
 
-    auto getLnGamma = [ this ](const std::vector<double>& arg_x) {
-        return Elvas::getLnGamma(_lndgamma, arg_x.at(0), arg_x.at(1));
+    auto getLnGamma = [ this ](const ASTReader::ArgSpan& arg_x) {
+        if (arg_x.size() > 3) {
+            throw EScriptError("get_lngamma: Too many arguments.");
+        }
+        double lngamma, error = NAN;
+        size_t nEval = Elvas::nInteg;
+        if (arg_x.size() == 3) {
+            lngamma = Elvas::getLnGamma(_lndgamma.sortedByFirst(), arg_x.at(0), arg_x.at(1), arg_x.at(2), nEval, error);
+        } else {
+            lngamma = Elvas::getLnGamma(_lndgamma.sortedByFirst(), arg_x.at(0), arg_x.at(1));
+        }
+        _eval.setSlot(_slots.lnGammaEvals, nEval);
+        _eval.setSlot(_slots.lnGammaError, error);
+        return lngamma;
     };
 
-    auto outputPrecision = [ &arg_os ](const std::vector<double>& arg_x) {
+    // The six SM beta functions are called with the same couplings in a
+    // row, so they are computed together and kept for the next calls.
+    std::fill(_smCouplings, _smCouplings + 6, std::nan(""));
+    auto smBeta = [ this ](const ASTReader::ArgSpan& arg_x, const size_t& arg_i) {
+        if (!std::equal(arg_x.begin(), arg_x.end(), _smCouplings)) {
+            std::copy(arg_x.begin(), arg_x.end(), _smCouplings);
+            Elvas::smBeta(_smCouplings, _smBeta);
+        }
+        return _smBeta[arg_i];
+    };
+
+    auto outputPrecision = [ &arg_os ](const ASTReader::ArgSpan& arg_x) {
         arg_os << std::setprecision((int) (arg_x.front() + 0.5));
         return 0.;
     };
 
-    setFunc("InstantonB", 0, InstantonB);
-    setFunc("HiggsQC", 0, HiggsQC);
-    setFunc("ScalarQC", 1, ScalarQC);
-    setFunc("FermionQC", 1, FermionQC);
-    setFunc("GaugeQC", 1, GaugeQC);
+    setFunc("InstantonB", 0, InstantonB, InstantonBBatch);
+    setFunc("HiggsQC", 0, HiggsQC, HiggsQCBatch);
+    setFunc("ScalarQC", 1, ScalarQC, ScalarQCBatch);
+    setFunc("FermionQC", 1, FermionQC, FermionQCBatch);
+    setFunc("GaugeQC", 1, GaugeQC, GaugeQCBatch);
     setFunc("output_precision", 1, outputPrecision);
+    const char* smCouplings[] = {"g1", "g2", "g3", "yt", "yb", "lambda"};
+    for (size_t i = 0; i < 6; i++) {
+        setFunc(std::string("sm_beta_") + smCouplings[i], 6, [ smBeta, i ](const ASTReader::ArgSpan& arg_x) {
+            return smBeta(arg_x, i);
+        });
+    }
     setFunc("initialize", 0, initialize);
-    setFunc("save_phiC", 0, saveLnPhiC);
-    setFunc("save_lndgamma_dRinv", 1, saveLnDGamma);
+    setFunc("save_phiC", 0, saveLnPhiC, saveLnPhiCBatch);
+    setFunc("save_lndgamma_dRinv", 1, saveLnDGamma, saveLnDGammaBatch);
     setFunc("is_data_enough", 0, checkSize);
     setFunc("get_max_lnRinv", 1, getMaxLnRinv);
     setFunc("get_min_lnRinv", 1, getMinLnRinv);
-    setFunc("get_lngamma", 2, getLnGamma);
+    setFunc("get_lngamma", -2, getLnGamma);
+    // get_lngamma sets LNGAMMA_EVALS and LNGAMMA_ERROR; the others assign
+    // no variable.
+    for (const auto& name : {"InstantonB", "HiggsQC", "ScalarQC", "FermionQC", "GaugeQC", "output_precision",
+            "initialize", "save_phiC", "save_lndgamma_dRinv", "is_data_enough", "get_max_lnRinv", "get_min_lnRinv"}) {
+        setEffect(name, 'N');
+    }
+    for (const auto& coupling : smCouplings) {
+        setEffect(std::string("sm_beta_") + coupling, 'P');
+    }
+    setWrites("get_lngamma", {"LNGAMMA_EVALS", "LNGAMMA_ERROR"});
+    // The batch versions read the couplings of the record.
+    setReads("InstantonB", {"HIGGS_QUARTIC_COUPLING"});
+    for (const auto& name : {"HiggsQC", "ScalarQC", "FermionQC", "GaugeQC"}) {
+        setReads(name, {"HIGGS_QUARTIC_COUPLING", "LN_QR"});
+    }
+    setReads("save_phiC", {"HIGGS_QUARTIC_COUPLING", "LN_RINV"});
+    setReads("save_lndgamma_dRinv", {"LN_RINV"});
+    // Compiled models call the quantum corrections directly.
+    setNative("InstantonB", "$f(-${HIGGS_QUARTIC_COUPLING})", "double (*)(double)",
+            reinterpret_cast<void (*)()> (+[](double arg_lambdaAbs) {
+                return Elvas::instantonB(arg_lambdaAbs);
+            }));
+    setNative("HiggsQC", "$f(-${HIGGS_QUARTIC_COUPLING}, ${LN_QR})", "double (*)(double, double)",
+            reinterpret_cast<void (*)()> (+[](double arg_lambdaAbs, double arg_lnQR) {
+                return Elvas::higgsQC(arg_lambdaAbs, arg_lnQR);
+            }));
+    setNative("ScalarQC", "$f($0, -${HIGGS_QUARTIC_COUPLING}, ${LN_QR})", "double (*)(double, double, double)",
+            reinterpret_cast<void (*)()> (+[](double arg_kappa, double arg_lambdaAbs, double arg_lnQR) {
+                return Elvas::scalarQC(arg_kappa, arg_lambdaAbs, arg_lnQR);
+            }));
+    setNative("FermionQC", "$f($0, -${HIGGS_QUARTIC_COUPLING}, ${LN_QR})", "double (*)(double, double, double)",
+            reinterpret_cast<void (*)()> (+[](double arg_y, double arg_lambdaAbs, double arg_lnQR) {
+                return Elvas::fermionQC(arg_y, arg_lambdaAbs, arg_lnQR);
+            }));
+    setNative("GaugeQC", "$f($0, -${HIGGS_QUARTIC_COUPLING}, ${LN_QR})", "double (*)(double, double, double)",
+            reinterpret_cast<void (*)()> (+[](double arg_gSquared, double arg_lambdaAbs, double arg_lnQR) {
+                return Elvas::gaugeQC(arg_gSquared, arg_lambdaAbs, arg_lnQR);
+            }));
 }
\ No newline at end of file
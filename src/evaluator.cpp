@@ -136,41 +136,139 @@ void ASTReader::PrintAST::operator()(const AST::_FuncDef& arg_ast) {
     boost::apply_visitor(*this, arg_ast.expr);
 }
 
-ASTReader::Evaluator::Evaluator() {
-    _constants["pi"] = M_PI;
-    setFunc("sqrt", 1, _sqrt);
-    setFunc("max", -2, _max);
-    setFunc("min", -2, _min);
-    setFunc("pow", 2, _pow);
-    setFunc("exp", 1, _exp);
-    setFunc("log", 1, _log);
-    setFunc("log10", 1, _log10);
-    setFunc("sin", 1, _sin);
-    setFunc("cos", 1, _cos);
-    setFunc("tan", 1, _tan);
-    setFunc("abs", 1, _abs);
-    setFunc("asin", 1, _asin);
-    setFunc("acos", 1, _acos);
-    setFunc("atan", 1, _atan);
-    setFunc("eval", -1, _eval);
+ASTReader::Evaluator::Evaluator() : _regTop(0), _profiler(nullptr) {
+    setConst("pi", M_PI);
+    setFunc("sqrt", 1, _sqrt, _elementwise(_sqrt));
+    setFunc("max", -2, _max, _elementwise(_max));
+    setFunc("min", -2, _min, _elementwise(_min));
+    setFunc("pow", 2, _pow, _elementwise(_pow));
+    setFunc("exp", 1, _exp, _elementwise(_exp));
+    setFunc("log", 1, _log, _elementwise(_log));
+    setFunc("log10", 1, _log10, _elementwise(_log10));
+    setFunc("sin", 1, _sin, _elementwise(_sin));
+    setFunc("cos", 1, _cos, _elementwise(_cos));
+    setFunc("tan", 1, _tan, _elementwise(_tan));
+    setFunc("abs", 1, _abs, _elementwise(_abs));
+    setFunc("asin", 1, _asin, _elementwise(_asin));
+    setFunc("acos", 1, _acos, _elementwise(_acos));
+    setFunc("atan", 1, _atan, _elementwise(_atan));
+    setFunc("eval", -1, _eval, _elementwise(_eval));
     setFunc("exit", 0, _exit);
+    for (const auto& name : {"sqrt", "max", "min", "pow", "exp", "log", "log10", "sin", "cos", "tan", "abs", "asin", "acos", "atan", "eval"}) {
+        setEffect(name, 'P');
+    }
+    for (const auto& name : {"sqrt", "exp", "log", "log10", "sin", "cos", "tan", "asin", "acos", "atan"}) {
+        setNative(name, std::string("std::") + name + "($0)");
+    }
+    setNative("abs", "std::fabs($0)");
+    setNative("pow", "std::pow($0, $1)");
 }
 
-double ASTReader::Evaluator::operator()(const AST::_Constant& arg_ast) {
-    auto it_cons = _constants.find(arg_ast);
-    if (it_cons != _constants.end()) {
-        return _constants.at(arg_ast);
-    } else {
-        auto it_func = _functions.find(arg_ast);
-        if (it_func != _functions.end() && it_func->second.first == 0) {
-            return (it_func->second.second)(std::vector<double>{});
-        } else {
-            throw ASTReadError("Constant not found. (" + arg_ast + ")");
+ASTReader::BatchBuiltin ASTReader::Evaluator::_elementwise(const Builtin& arg_func) {
+    return [arg_func](const BatchArgs& arg_x, double* arg_result) {
+        std::vector<double> x(arg_x.argNum());
+        for (size_t i = 0; i < arg_x.size(); i++) {
+            if (arg_x.active()[i]) {
+                for (size_t arg = 0; arg < x.size(); arg++) {
+                    x[arg] = arg_x[arg][i];
+                }
+                arg_result[i] = arg_func(x);
+            }
         }
+    };
+}
+
+double ASTReader::Evaluator::_loadUnset(const int32_t& arg_slot) {
+    const std::string& name = _vars.name(arg_slot);
+    int32_t func = _funcs.find(name);
+    if (func >= 0 && (size_t) func < _funcTable.size() && _funcTable[func].isSet() && _funcTable[func].argNum == 0) {
+        return _call(func, nullptr, 0);
+    } else {
+        throw ASTReadError("Constant not found. (" + name + ")");
     }
     return std::nan("");
 }
 
+double ASTReader::Evaluator::_call(const int32_t& arg_func, const double* arg_x, const size_t& arg_argNum) {
+    if (arg_func < 0 || (size_t) arg_func >= _funcTable.size() || !_funcTable[arg_func].isSet() || !_funcTable[arg_func].accepts(arg_argNum)) {
+        throw ASTReadError("Function not found or wrong number of arguments. (" + _funcs.name(arg_func) + ")");
+    }
+    const Function& func = _funcTable[arg_func];
+    if (func.builtin) {
+        Profiler::Scope scope(_profiler ? _profiler->func(arg_func) : nullptr);
+        return func.builtin(ArgSpan(arg_x, arg_argNum));
+    }
+    std::shared_ptr<const Program> body = func.body;
+    return execute(*body, arg_x, std::min<size_t>(arg_argNum, func.argNum));
+}
+
+double ASTReader::Evaluator::_nativeLoad(NativeHost* arg_host, int32_t arg_slot) {
+    Evaluator& eval = *static_cast<Evaluator*> (arg_host->eval);
+    const double result = eval._loadUnset(arg_slot);
+    arg_host->frame = eval._frame.data();
+    arg_host->isSet = eval._isSet.data();
+    return result;
+}
+
+double ASTReader::Evaluator::_nativeCall(NativeHost* arg_host, int32_t arg_func, const double* arg_x, size_t arg_argNum) {
+    Evaluator& eval = *static_cast<Evaluator*> (arg_host->eval);
+    const double result = eval._call(arg_func, arg_x, arg_argNum);
+    arg_host->frame = eval._frame.data();
+    arg_host->isSet = eval._isSet.data();
+    return result;
+}
+
+void ASTReader::Evaluator::_define(const FuncDefinition& arg_def) {
+    if (_funcTable.size() <= (size_t) arg_def.func) {
+        _funcTable.resize(arg_def.func + 1);
+    }
+    _funcTable[arg_def.func] = Function{(int) arg_def.argNum, nullptr, arg_def.body};
+}
+
+void ASTReader::Evaluator::adopt(const Evaluator& arg_master) {
+    std::vector<std::pair<std::string, Function>> builtins;
+    for (size_t i = 0; i < _funcTable.size(); i++) {
+        if (_funcTable[i].builtin) {
+            builtins.emplace_back(_funcs.name(i), _funcTable[i]);
+        }
+    }
+    _vars = arg_master._vars;
+    _funcs = arg_master._funcs;
+    _frame = arg_master._frame;
+    _isSet = arg_master._isSet;
+    _funcTable = arg_master._funcTable;
+    for (auto& elem : builtins) {
+        int32_t func = _funcs.find(elem.first);
+        if (func >= 0 && (size_t) func < _funcTable.size() && _funcTable[func].builtin) {
+            _funcTable[func] = std::move(elem.second);
+        }
+    }
+}
+
+void ASTReader::Evaluator::restore(const Evaluator& arg_master, const std::vector<int32_t>& arg_slots) {
+    _fitFrame();
+    const size_t size = std::min(_frame.size(), arg_master._frame.size());
+    std::copy(arg_master._frame.begin(), arg_master._frame.begin() + size, _frame.begin());
+    std::copy(arg_master._isSet.begin(), arg_master._isSet.begin() + size, _isSet.begin());
+    for (const auto& slot : arg_slots) {
+        _isSet.at(slot) = false;
+    }
+}
+
+void ASTReader::Evaluator::collect(const std::vector<int32_t>& arg_slots, std::vector<std::pair<int32_t, double>>& arg_vals) const {
+    for (const auto& slot : arg_slots) {
+        if ((size_t) slot < _isSet.size() && _isSet[slot]) {
+            arg_vals.emplace_back(slot, _frame[slot]);
+        }
+    }
+}
+
+double ASTReader::Evaluator::operator()(const AST::_Constant& arg_ast) {
+    int32_t slot = _vars.intern(arg_ast);
+    _fitFrame();
+    return _isSet[slot] ? _frame[slot] : _loadUnset(slot);
+}
+
 double ASTReader::Evaluator::operator()(AST::_If& arg_ast) {
     if (arg_ast.arguments.size() == 1) {
         if (boost::apply_visitor(*this, arg_ast.test) >= 0.5) {
@@ -195,15 +293,7 @@ double ASTReader::Evaluator::operator()(AST::_FuncCall& arg_ast) {
     for (auto& elem : arg_ast.arguments) {
         arguments.emplace_back(boost::apply_visitor(*this, elem));
     }
-    if (!arg_ast.function) {
-        auto it_func = _functions.find(arg_ast.funcName);
-        if (it_func != _functions.end() && (it_func->second.first == arguments.size() || -(it_func->second.first) <= arguments.size())) {
-            arg_ast.function = it_func->second.second;
-        } else {
-            throw ASTReadError("Function not found or wrong number of arguments. (" + arg_ast.funcName + ")");
-        }
-    }
-    return arg_ast.function(arguments);
+    return _call(_funcs.intern(arg_ast.funcName), arguments.data(), arguments.size());
 }
 
 double ASTReader::Evaluator::operator()(AST::_Times & arg_ast) {
@@ -227,11 +317,11 @@ double ASTReader::Evaluator::operator()(AST::_Plus & arg_ast) {
 }
 
 double ASTReader::Evaluator::operator()(AST::_Relational & arg_ast) {
-    std::vector<double> lhsrhs(2);
-    lhsrhs.at(0) = boost::apply_visitor(*this, arg_ast.first);
-    lhsrhs.at(1) = boost::apply_visitor(*this, arg_ast.rest.operand);
-    return lhsrhs.at(arg_ast.rest.operation.front() == '>') < lhsrhs.at(arg_ast.rest.operation.front() == '<')
-            || (arg_ast.rest.operation.length() == 2 && lhsrhs.at(0) == lhsrhs.at(1)) == (arg_ast.rest.operation.front() != '!');
+    double lhsrhs[2];
+    lhsrhs[0] = boost::apply_visitor(*this, arg_ast.first);
+    lhsrhs[1] = boost::apply_visitor(*this, arg_ast.rest.operand);
+    return lhsrhs[arg_ast.rest.operation.front() == '>'] < lhsrhs[arg_ast.rest.operation.front() == '<']
+            || (arg_ast.rest.operation.length() == 2 && lhsrhs[0] == lhsrhs[1]) == (arg_ast.rest.operation.front() != '!');
 }
 
 double ASTReader::Evaluator::operator()(AST::_AndRel & arg_ast) {
@@ -259,21 +349,136 @@ double ASTReader::Evaluator::operator()(AST::_Substitute& arg_ast) {
 }
 
 double ASTReader::Evaluator::operator()(AST::_FuncDef& arg_ast) {
-    std::unordered_map<std::string, std::string> rule;
-    int i = 0;
-    for (const auto& name : arg_ast.fName.fArgs) {
-        rule.emplace(name, "_INTERNAL_VARS_" + std::to_string(i));
-        i++;
+    return execute(Compiler::compile(arg_ast, _vars, _funcs));
+}
+
+double ASTReader::Evaluator::execute(const Program& arg_prog, const double* arg_x, const size_t& arg_argNum) {
+    if (arg_prog.native) {
+        _fitFrame();
+        NativeHost host{_frame.data(), _isSet.data(), _nativeLoad, _nativeCall, this};
+        return arg_prog.native(&host);
     }
-    ChangeConstName chConst(rule);
-    AST::Substitute& expr = arg_ast.expr;
-    chConst(expr);
-    setFunc(arg_ast.fName.fName, arg_ast.fName.fArgs.size(), [ this, expr ](const std::vector<double>& arg_x) mutable {
-        size_t i;
-        for (i = 0; i < arg_x.size(); i++) {
-            setConst("_INTERNAL_VARS_" + std::to_string(i), arg_x.at(i));
+    struct Stack {
+        size_t& top;
+        size_t base;
+        std::vector<std::vector<double>>& retired;
+
+        ~Stack() {
+            top = base;
+            if (base == 0) {
+                retired.clear();
+            }
         }
-        return (*this)(expr);
-    });
-    return 0.;
+    } stack{_regTop, _regTop, _retiredRegs};
+
+    _regTop += arg_prog.nRegs;
+    if (_regs.size() < _regTop) {
+        // Arguments passed to builtins point into the register stack, so the
+        // old storage is kept alive until the outermost call returns.
+        std::vector<double> regs(std::max(_regTop, 2 * _regs.size()));
+        std::copy(_regs.begin(), _regs.end(), regs.begin());
+        _retiredRegs.emplace_back(std::move(_regs));
+        _regs = std::move(regs);
+    }
+    _fitFrame();
+    double* reg = _regs.data() + stack.base;
+    std::copy(arg_x, arg_x + arg_argNum, reg);
+    double* frame = _frame.data();
+    char* isSet = _isSet.data();
+
+    const Instruction* code = arg_prog.code.data();
+    const size_t codeSize = arg_prog.code.size();
+    size_t pc = 0;
+    while (pc < codeSize) {
+        const Instruction& inst = code[pc++];
+        switch (inst.op) {
+            case OpCode::LoadNum:
+                reg[inst.dst] = arg_prog.numbers[inst.a];
+                break;
+            case OpCode::LoadVar:
+                if (isSet[inst.a]) {
+                    reg[inst.dst] = frame[inst.a];
+                } else {
+                    reg[inst.dst] = _loadUnset(inst.a);
+                    reg = _regs.data() + stack.base;
+                    frame = _frame.data();
+                    isSet = _isSet.data();
+                }
+                break;
+            case OpCode::StoreVar:
+                frame[inst.a] = reg[inst.dst];
+                isSet[inst.a] = true;
+                break;
+            case OpCode::Move:
+                reg[inst.dst] = reg[inst.a];
+                break;
+            case OpCode::Neg:
+                reg[inst.dst] = -reg[inst.a];
+                break;
+            case OpCode::Add:
+                reg[inst.dst] = reg[inst.a] + reg[inst.b];
+                break;
+            case OpCode::Mul:
+                reg[inst.dst] = reg[inst.a] * reg[inst.b];
+                break;
+            case OpCode::Div:
+                reg[inst.dst] = reg[inst.a] / reg[inst.b];
+                break;
+            case OpCode::Pow:
+                reg[inst.dst] = pow(reg[inst.a], reg[inst.b]);
+                break;
+            case OpCode::PowInt:
+                reg[inst.dst] = NTools::powInt(reg[inst.a], inst.b);
+                break;
+            case OpCode::Less:
+                reg[inst.dst] = reg[inst.a] < reg[inst.b];
+                break;
+            case OpCode::LessEq:
+                reg[inst.dst] = reg[inst.a] <= reg[inst.b];
+                break;
+            case OpCode::Greater:
+                reg[inst.dst] = reg[inst.a] > reg[inst.b];
+                break;
+            case OpCode::GreaterEq:
+                reg[inst.dst] = reg[inst.a] >= reg[inst.b];
+                break;
+            case OpCode::Equal:
+                reg[inst.dst] = reg[inst.a] == reg[inst.b];
+                break;
+            case OpCode::NotEqual:
+                reg[inst.dst] = reg[inst.a] != reg[inst.b];
+                break;
+            case OpCode::Truth:
+                reg[inst.dst] = reg[inst.a] >= 0.5;
+                break;
+            case OpCode::Jump:
+                pc = inst.dst;
+                break;
+            case OpCode::JumpIfFalse:
+                if (!(reg[inst.a] >= 0.5)) {
+                    pc = inst.dst;
+                }
+                break;
+            case OpCode::JumpIfTrue:
+                if (reg[inst.a] >= 0.5) {
+                    pc = inst.dst;
+                }
+                break;
+            case OpCode::Call:
+            {
+                const CallSite& site = arg_prog.calls[inst.b];
+                double result = _call(site.func, reg + inst.a, site.argNum);
+                reg = _regs.data() + stack.base;
+                frame = _frame.data();
+                isSet = _isSet.data();
+                reg[inst.dst] = result;
+                break;
+            }
+            case OpCode::Define:
+                _define(arg_prog.defs[inst.a]);
+                reg[inst.dst] = 0.;
+                break;
+        }
+    }
+    return arg_prog.code.empty() ? 0. : reg[arg_prog.result];
 }
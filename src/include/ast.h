@@ -47,7 +47,6 @@ namespace AST {
     using _Recursion = Substitute;
 
     struct _FuncCall : x3::position_tagged {
-        std::function<double(const std::vector<double>&) > function;
         std::string funcName;
         std::vector<_Recursion> arguments;
     };
@@ -0,0 +1,53 @@
+/**
+ * @file chain_stream.h
+ * @brief Input stream reading several files in sequence
+ * @date Created on: 2026/10/17, 17:30
+ */
+
+#ifndef CHAIN_STREAM_H
+#define CHAIN_STREAM_H
+
+#include <fstream>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Stream buffer that walks the given files in order through a buffer of
+ * fixed size, so that the input is never held in memory as a whole.
+ * Positions count the bytes of all files, and only the files already
+ * opened can be sought back to.
+ */
+class ChainStreamBuf : public std::streambuf {
+protected:
+    std::vector<std::string> _paths;
+    size_t _next;
+    std::filebuf _file;
+    std::vector<char> _buf;
+    // Positions of the start of each file opened and of _buf.
+    std::vector<off_type> _starts;
+    off_type _pos;
+
+    int_type underflow() override;
+
+    pos_type seekoff(off_type arg_off, std::ios_base::seekdir arg_dir, std::ios_base::openmode arg_which) override;
+
+    pos_type seekpos(pos_type arg_pos, std::ios_base::openmode arg_which) override;
+
+public:
+
+    ChainStreamBuf(const std::vector<std::string>& arg_paths, const size_t& arg_bufSize = 1 << 16);
+};
+
+class ChainStream : public std::istream {
+protected:
+    ChainStreamBuf _sbuf;
+public:
+
+    ChainStream(const std::vector<std::string>& arg_paths) : std::istream(nullptr), _sbuf(arg_paths) {
+        rdbuf(&_sbuf);
+    }
+};
+
+#endif /* CHAIN_STREAM_H */
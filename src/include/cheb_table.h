@@ -0,0 +1,75 @@
+/**
+ * @file cheb_table.h
+ * @brief Piecewise Chebyshev approximation of smooth functions
+ * @date Created on: 2026/10/17, 23:59
+ */
+
+#ifndef CHEB_TABLE_H
+#define CHEB_TABLE_H
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * A function on [2^expMin, 2^expMax) as a table of polynomials, one per
+ * piece of an octave, each interpolating the function at the Chebyshev
+ * nodes of its piece. The piece of x is read from the bits of x, and the
+ * polynomial is evaluated by Horner's rule in the position within the
+ * piece, so a value costs a subtraction and one multiply-add per degree.
+ *
+ * The error relative to max(1, |f(x)|) is measured on a dense sample of
+ * every piece when the table is built; see maxError.
+ */
+class ChebTable {
+    double _xMin, _xMax;
+    int _shift, _stride;
+    uint64_t _first;
+    // Per piece: the center, the inverse half width and the coefficients
+    // from the constant one on.
+    std::vector<double> _coeffs;
+    double _maxError;
+
+public:
+
+    class ChebTableError : public std::runtime_error {
+    public:
+
+        ChebTableError(const std::string& str) : std::runtime_error(str) {
+        }
+    };
+
+    /**
+     * Tabulates arg_f with 2^arg_log2Pieces pieces per octave and
+     * polynomials of degree arg_degree. Throws ChebTableError if arg_f is
+     * not finite on the range.
+     */
+    ChebTable(const std::function<double(const double&)>& arg_f, const int& arg_expMin, const int& arg_expMax, const int& arg_log2Pieces, const int& arg_degree);
+
+    bool covers(const double& arg_x) const {
+        return arg_x >= _xMin && arg_x < _xMax;
+    }
+
+    /**
+     * The value at arg_x, which must be covered.
+     */
+    double operator()(const double& arg_x) const {
+        uint64_t bits;
+        std::memcpy(&bits, &arg_x, sizeof (bits));
+        const double* c = _coeffs.data() + ((bits >> _shift) - _first) * _stride;
+        const double t = (arg_x - c[0]) * c[1];
+        double result = c[_stride - 1];
+        for (int k = _stride - 2; k >= 2; k--) {
+            result = result * t + c[k];
+        }
+        return result;
+    }
+
+    double maxError() const {
+        return _maxError;
+    }
+};
+
+#endif /* CHEB_TABLE_H */
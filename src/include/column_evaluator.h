@@ -0,0 +1,75 @@
+/**
+ * @file column_evaluator.h
+ * @brief Column-wise execution of routines over the records of a dataset
+ * @date Created on: 2026/10/17, 19:20
+ */
+
+#ifndef COLUMN_EVALUATOR_H
+#define COLUMN_EVALUATOR_H
+
+#include "evaluator.h"
+#include <deque>
+
+namespace ASTReader {
+
+    /**
+     * Runs a list of programs over many records at once. Every register
+     * holds a column with one value per record, and each record follows its
+     * own path through the forward jumps of a program under a mask. Builtins
+     * are applied through their batch versions.
+     *
+     * The result is the same as running the records one by one as long as
+     * no record depends on the one before, which prepare checks.
+     */
+    class ColumnEvaluator {
+    protected:
+        Evaluator& _eval;
+        const std::vector<Program>* _progs;
+        std::vector<int32_t> _recordSlots, _storedSlots;
+        std::vector<char> _isRecord, _isStored;
+        size_t _size;
+        std::vector<std::vector<double>> _columns;
+        std::vector<std::vector<char>> _written;
+        std::vector<char> _dropped;
+        std::vector<size_t> _index;
+        std::vector<std::pair<size_t, double>> _last;
+        std::deque<std::vector<double>> _scratch;
+
+        bool _check(const Program& arg_prog, std::vector<char>& arg_defined, std::vector<const Program*>& arg_stack) const;
+
+        std::vector<double> _run(const Program& arg_prog, const std::vector<const double*>& arg_args, const std::vector<char>& arg_active);
+
+        const double* _var(const std::string& arg_name, const char* arg_active);
+
+        void _retire(const std::vector<char>& arg_keep);
+
+        void _commit();
+
+    public:
+        static const size_t chunkSize = 1024;
+
+        ColumnEvaluator(Evaluator& arg_eval) : _eval(arg_eval), _progs(nullptr), _size(0) {
+        }
+
+        /**
+         * Decides whether arg_progs can run column-wise with the current
+         * state of the evaluator. Every variable a record reads must either
+         * be one of arg_recordSlots, be set before the routine and never
+         * assigned in it, or be assigned earlier on every path of the same
+         * record. Every call must reach a builtin with a batch version, whose
+         * reads declared by Evaluator::setReads follow the same rule, or a
+         * user-defined function that assigns no variable. Otherwise the
+         * routines are left to run record by record.
+         */
+        bool prepare(const std::vector<Program>& arg_progs, const std::vector<int32_t>& arg_recordSlots);
+
+        /**
+         * Runs the prepared programs over arg_nRecords records given as one
+         * column per record variable. Afterwards each variable holds the
+         * value assigned by the last record, as in the record-wise run.
+         */
+        void execute(const std::vector<const double*>& arg_columns, const size_t& arg_nRecords);
+    };
+}
+
+#endif /* COLUMN_EVALUATOR_H */
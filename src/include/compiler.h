@@ -0,0 +1,228 @@
+/**
+ * @file compiler.h
+ * @brief AST to register bytecode compiler
+ * @date Created on: 2026/10/17, 10:12
+ */
+
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include "ast.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ASTReader {
+
+    enum class OpCode : uint8_t {
+        LoadNum, LoadVar, StoreVar, Move,
+        Neg, Add, Mul, Div, Pow, PowInt,
+        Less, LessEq, Greater, GreaterEq, Equal, NotEqual, Truth,
+        Jump, JumpIfFalse, JumpIfTrue,
+        Call, Define
+    };
+
+    /**
+     * One instruction of the register machine.
+     * dst, a and b are register numbers, except for
+     * LoadVar/StoreVar where a is a slot of the variable table,
+     * LoadNum/Call/Define where a or b indexes a table of the program,
+     * PowInt where b is the exponent and Jump* where dst is the target.
+     * The arguments of a user-defined function occupy its first registers.
+     */
+    struct Instruction {
+        OpCode op;
+        int32_t dst, a, b;
+    };
+
+    /**
+     * Interns identifiers into dense slots of the evaluator's value frame
+     * or function table.
+     */
+    class SymbolTable {
+        std::unordered_map<std::string, int32_t> _index;
+        std::vector<std::string> _names;
+    public:
+
+        int32_t intern(const std::string& arg_name) {
+            auto it_index = _index.find(arg_name);
+            if (it_index != _index.end()) {
+                return it_index->second;
+            }
+            _names.emplace_back(arg_name);
+            return _index[arg_name] = _names.size() - 1;
+        }
+
+        int32_t find(const std::string& arg_name) const {
+            auto it_index = _index.find(arg_name);
+            return it_index != _index.end() ? it_index->second : -1;
+        }
+
+        const std::string& name(const int32_t& arg_slot) const {
+            return _names.at(arg_slot);
+        }
+
+        size_t size() const {
+            return _names.size();
+        }
+    };
+
+    class Program;
+
+    struct CallSite {
+        int32_t func;
+        size_t argNum;
+    };
+
+    struct FuncDefinition {
+        int32_t func;
+        size_t argNum;
+        std::shared_ptr<const Program> body;
+    };
+
+    /**
+     * What a line compiled into native code by NativeModel sees of the
+     * evaluator: the value frame, which moves when it grows, a read of an
+     * unset variable and a call as in a script. Shared with the generated
+     * code by layout, so NativeModel::abi changes with it.
+     */
+    struct NativeHost {
+        double* frame;
+        char* isSet;
+        double (*load)(NativeHost* arg_host, int32_t arg_slot);
+        double (*call)(NativeHost* arg_host, int32_t arg_func, const double* arg_x, size_t arg_argNum);
+        void* eval;
+    };
+
+    class Program {
+    public:
+        std::vector<Instruction> code;
+        std::vector<double> numbers;
+        std::vector<CallSite> calls;
+        std::vector<FuncDefinition> defs;
+        int32_t nRegs = 0;
+        int32_t result = 0;
+        int32_t line = 0;
+        // Run instead of code if set; see NativeModel.
+        double (*native)(NativeHost* arg_host) = nullptr;
+    };
+
+    class Compiler {
+    protected:
+        Program& _prog;
+        SymbolTable& _vars;
+        SymbolTable& _funcs;
+        std::unordered_map<std::string, int32_t> _args;
+        int32_t _next;
+
+        int32_t _alloc() {
+            int32_t reg = _next++;
+            if (_prog.nRegs < _next) {
+                _prog.nRegs = _next;
+            }
+            return reg;
+        }
+
+        void _emit(OpCode arg_op, int32_t arg_dst, int32_t arg_a = 0, int32_t arg_b = 0) {
+            _prog.code.push_back(Instruction{arg_op, arg_dst, arg_a, arg_b});
+        }
+
+        size_t _emitJump(OpCode arg_op, int32_t arg_test) {
+            _emit(arg_op, -1, arg_test);
+            return _prog.code.size() - 1;
+        }
+
+        void _patch(size_t arg_pos) {
+            _prog.code.at(arg_pos).dst = _prog.code.size();
+        }
+
+        Compiler(Program& arg_prog, SymbolTable& arg_vars, SymbolTable& arg_funcs) : _prog(arg_prog), _vars(arg_vars), _funcs(arg_funcs), _next(0) {
+        }
+
+    public:
+
+        template<class Node>
+        static Program compile(const Node& arg_ast, SymbolTable& arg_vars, SymbolTable& arg_funcs, const std::vector<std::string>& arg_args = {}) {
+            Program prog;
+            Compiler compiler(prog, arg_vars, arg_funcs);
+            for (const auto& name : arg_args) {
+                compiler._args.emplace(name, compiler._alloc());
+            }
+            prog.result = compiler(arg_ast);
+            return prog;
+        }
+
+        int32_t operator()(const double& arg_ast);
+
+        int32_t operator()(const AST::_Constant& arg_ast);
+
+        int32_t operator()(const AST::_If& arg_ast);
+
+        int32_t operator()(const AST::_FuncCall& arg_ast);
+
+        int32_t operator()(const AST::Primary& arg_ast) {
+            return boost::apply_visitor(*this, arg_ast);
+        }
+
+        int32_t operator()(const AST::_Signed& arg_ast);
+
+        int32_t operator()(const AST::Signed& arg_ast) {
+            return boost::apply_visitor(*this, arg_ast);
+        }
+
+        int32_t operator()(const AST::_PowerUnary& arg_ast);
+
+        int32_t operator()(const AST::_PowerInt& arg_ast);
+
+        int32_t operator()(const AST::Power& arg_ast) {
+            return boost::apply_visitor(*this, arg_ast);
+        }
+
+        int32_t operator()(const AST::_Times& arg_ast);
+
+        int32_t operator()(const AST::Times& arg_ast) {
+            return boost::apply_visitor(*this, arg_ast);
+        }
+
+        int32_t operator()(const AST::_Plus& arg_ast);
+
+        int32_t operator()(const AST::Plus& arg_ast) {
+            return boost::apply_visitor(*this, arg_ast);
+        }
+
+        int32_t operator()(const AST::_Relational& arg_ast);
+
+        int32_t operator()(const AST::Relational& arg_ast) {
+            return boost::apply_visitor(*this, arg_ast);
+        }
+
+        int32_t operator()(const AST::_AndRel& arg_ast);
+
+        int32_t operator()(const AST::AndRel& arg_ast) {
+            return boost::apply_visitor(*this, arg_ast);
+        }
+
+        int32_t operator()(const AST::_OrRel& arg_ast);
+
+        int32_t operator()(const AST::OrRel& arg_ast) {
+            return boost::apply_visitor(*this, arg_ast);
+        }
+
+        int32_t operator()(const AST::_Substitute& arg_ast);
+
+        int32_t operator()(const AST::Substitute& arg_ast) {
+            return boost::apply_visitor(*this, arg_ast);
+        }
+
+        int32_t operator()(const AST::_FuncDef& arg_ast);
+
+        int32_t operator()(const AST::Expression& arg_ast) {
+            return boost::apply_visitor(*this, arg_ast);
+        }
+    };
+}
+
+#endif /* COMPILER_H */
@@ -24,9 +24,53 @@ public:
         }
     };
 
-    static double lnPhiC2LnRinv(const double& arg_lnPhiC, std::vector<std::pair<double, double>>&arg_lnPhiC2lnRinv);
+    /**
+     * Pairs collected over a dataset. Whether the pairs are ordered by first
+     * or by second is tracked as they are added, so a table is sorted at
+     * most once however many times it is queried.
+     */
+    class Table {
+        std::vector<std::pair<double, double>> _data;
+        bool _isSortedFirst, _isSortedSecond;
+    public:
+
+        Table() : _isSortedFirst(true), _isSortedSecond(true) {
+        }
+
+        void clear() {
+            _data.clear();
+            _isSortedFirst = true;
+            _isSortedSecond = true;
+        }
+
+        void emplace_back(const double& arg_first, const double& arg_second) {
+            if (!_data.empty()) {
+                _isSortedFirst = _isSortedFirst && _data.back().first <= arg_first;
+                _isSortedSecond = _isSortedSecond && _data.back().second <= arg_second;
+            }
+            _data.emplace_back(arg_first, arg_second);
+        }
 
-    static double getLnGamma(std::vector<std::pair<double, double>>&arg_lndgam, const double& arg_lnRinvBeg, const double& arg_lnRinvEnd);
+        size_t size() const {
+            return _data.size();
+        }
+
+        const std::vector<std::pair<double, double>>& sortedByFirst();
+
+        const std::vector<std::pair<double, double>>& sortedBySecond();
+    };
+
+    static double lnPhiC2LnRinv(const double& arg_lnPhiC, const std::vector<std::pair<double, double>>&arg_lnPhiC2lnRinv);
+
+    static double getLnGamma(const std::vector<std::pair<double, double>>&arg_lndgam, const double& arg_lnRinvBeg, const double& arg_lnRinvEnd);
+
+    /**
+     * getLnGamma with adaptive integration. arg_tol bounds the error of the
+     * returned ln(gamma); the number of integrand evaluations and the
+     * estimated error are returned through arg_nEval and arg_error.
+     */
+    static double getLnGamma(const std::vector<std::pair<double, double>>&arg_lndgam, const double& arg_lnRinvBeg, const double& arg_lnRinvEnd,
+            const double& arg_tol, size_t& arg_nEval, double& arg_error);
 
     static double instantonB(const double& arg_lambdaAbs) {
         return 26.3189450695716 / arg_lambdaAbs;
@@ -36,12 +80,61 @@ public:
         return -0.99192944327027 + 2.5 * log(arg_lambdaAbs) - 3. * arg_lnQR;
     }
 
+    /**
+     * The quantum corrections of a scalar, a fermion and a gauge boson.
+     * Above the threshold of its expansion in x = coupling / |lambda|,
+     * each is a closed form in x. For gaugeQC, setKernels('T') selects a
+     * table of it for x below 2^14 instead.
+     */
     static double scalarQC(const double& arg_kappa, const double& arg_lambdaAbs, const double& arg_lnQR);
 
     static double fermionQC(const double& arg_y, const double& arg_lambdaAbs, const double& arg_lnQR);
 
     static double gaugeQC(const double& arg_gSquared, const double& arg_lambdaAbs, const double& arg_lnQR);
 
+    /**
+     * Selects how gaugeQC evaluates the part that depends on x alone: 'C'
+     * by the closed form, the default, or 'T' by a piecewise Chebyshev
+     * table of it, built on first selection. The table is within
+     * tableError() of the closed form, relative to max(1, |value|),
+     * below 2e-14. Not to be called while corrections are computed on
+     * other threads.
+     */
+    static void setKernels(const char& arg_kernels);
+
+    static char getKernels();
+
+    /**
+     * Largest error of the table measured when it was built, or zero if
+     * none is selected.
+     */
+    static double tableError();
+
+    /**
+     * Batch versions of the routines above over arrays of arg_n records.
+     * Both regimes of each expansion are evaluated and blended without
+     * branches, so that the loops vectorize. gaugeQC with a table computes
+     * the records one by one.
+     */
+    static void instantonB(const double* arg_lambdaAbs, double* arg_out, const size_t& arg_n);
+
+    static void higgsQC(const double* arg_lambdaAbs, const double* arg_lnQR, double* arg_out, const size_t& arg_n);
+
+    static void scalarQC(const double* arg_kappa, const double* arg_lambdaAbs, const double* arg_lnQR, double* arg_out, const size_t& arg_n);
+
+    static void fermionQC(const double* arg_y, const double* arg_lambdaAbs, const double* arg_lnQR, double* arg_out, const size_t& arg_n);
+
+    static void gaugeQC(const double* arg_gSquared, const double* arg_lambdaAbs, const double* arg_lnQR, double* arg_out, const size_t& arg_n);
+
+    /**
+     * Standard Model beta functions d(coupling)/d(ln Q) of arg_couplings =
+     * {g1, g2, g3, yt, yb, lambda} in the MS-bar scheme, with g1 in the
+     * GUT normalization and the potential lambda |H|^4. Two loops in the
+     * gauge couplings, yt and lambda; yb runs at one loop and is dropped
+     * from the two-loop terms of the others, as are the lighter fermions.
+     */
+    static void smBeta(const double* arg_couplings, double* arg_beta);
+
     class PrintBox {
         std::ostream& _out;
         int _ws;
@@ -0,0 +1,88 @@
+/**
+ * @file elvas_model.h
+ * @brief Embedding API of ELVAS
+ * @date Created on: 2026/10/17, 21:20
+ */
+
+#ifndef ELVAS_MODEL_H
+#define ELVAS_MODEL_H
+
+#include "elvas_script.h"
+#include <sstream>
+
+/**
+ * A model script loaded once and run on datasets given as arrays. The
+ * script is read and compiled, and [INITIALIZE] is run, on construction.
+ * Each call of run then executes [BEGIN_ROUTINE], [MAIN_ROUTINE] and
+ * [END_ROUTINE] for one dataset, and returns the arguments of every
+ * print call as a row of doubles. The state left by a dataset is seen by
+ * the next one, as in a script with several [DATASET] sections.
+ *
+ * Text printed by print("...") and errors are written to an internal
+ * stream, available through text().
+ */
+class ElvasModel {
+    std::istringstream _is;
+    std::ostringstream _os;
+    ElvasScript _script;
+    std::vector<std::vector<double>> _printed;
+
+public:
+
+    /**
+     * Loads a script given as a string. Throws Interpreter::InterpreterError
+     * on a syntax error.
+     */
+    explicit ElvasModel(const std::string& arg_script);
+
+    ElvasModel(const ElvasModel&) = delete;
+    ElvasModel& operator=(const ElvasModel&) = delete;
+
+    /**
+     * Reads a whole script file, for the constructor.
+     */
+    static std::string readFile(const std::string& arg_path);
+
+    /**
+     * Runs one dataset with arg_nRecords records of RECORD_VARS stored row
+     * by row in arg_records. The returned rows stay valid until the next
+     * call of run or finalize.
+     */
+    const std::vector<std::vector<double>>& run(const std::vector<double>& arg_datasetVals, const double* arg_records, const size_t& arg_nRecords);
+
+    const std::vector<std::vector<double>>& run(const std::vector<double>& arg_datasetVals, const std::vector<double>& arg_records);
+
+    const std::vector<std::string>& datasetVarNames() {
+        return _script.datasetVarNames();
+    }
+
+    const std::vector<std::string>& recordVarNames() {
+        return _script.recordVarNames();
+    }
+
+    /**
+     * Runs [FINALIZE] and returns its print results.
+     */
+    const std::vector<std::vector<double>>& finalize();
+
+    /**
+     * See Interpreter::setColumnar.
+     */
+    void setColumnar(const bool& arg_columnar) {
+        _script.setColumnar(arg_columnar);
+    }
+
+    void setConst(const std::string& arg_name, const double& arg_val) {
+        _script.setConst(arg_name, arg_val);
+    }
+
+    const double& getConst(const std::string& arg_name) const {
+        return _script.getConst(arg_name);
+    }
+
+    std::string text() const {
+        return _os.str();
+    }
+};
+
+#endif /* ELVAS_MODEL_H */
@@ -12,7 +12,21 @@
 #include "elvas.h"
 
 class ElvasScript : public Interpreter {
-    std::vector<std::pair<double, double>> _lndgamma, _lnPhiC;
+    Elvas::Table _lndgamma, _lnPhiC;
+    double _smCouplings[6], _smBeta[6];
+
+    /**
+     * Slots of the variables that the builtins read and write. They are
+     * interned first in the constructor, so that they are the same in the
+     * workers, which adopt the variable table of the master.
+     */
+    struct _Slots {
+        int32_t lambda, lnQR, lnRinv, lnGammaEvals, lnGammaError;
+    } _slots;
+
+    std::unique_ptr<Interpreter> _clone(std::ostream& arg_os) const override {
+        return std::unique_ptr<Interpreter>(new ElvasScript(_is, arg_os));
+    }
 public:
 
     class EScriptError : public std::runtime_error {
@@ -13,8 +13,11 @@
 #endif
 
 #include "ast.h"
+#include "compiler.h"
 #include "ntools.h"
+#include "profiler.h"
 #include <unordered_map>
+#include <deque>
 #include <iostream>
 
 namespace ASTReader {
@@ -259,72 +262,231 @@ namespace ASTReader {
 
     };
 
+    /**
+     * Read-only view of the arguments of a call. The values live on the
+     * register stack of the evaluator, so no allocation is made per call.
+     */
+    class ArgSpan {
+        const double* _data;
+        size_t _size;
+    public:
+
+        ArgSpan(const double* arg_data, const size_t& arg_size) : _data(arg_data), _size(arg_size) {
+        }
+
+        ArgSpan(const std::vector<double>& arg_vec) : _data(arg_vec.data()), _size(arg_vec.size()) {
+        }
+
+        size_t size() const {
+            return _size;
+        }
+
+        bool empty() const {
+            return _size == 0;
+        }
+
+        const double* begin() const {
+            return _data;
+        }
+
+        const double* end() const {
+            return _data + _size;
+        }
+
+        const double& operator[](const size_t& arg_i) const {
+            return _data[arg_i];
+        }
+
+        const double& at(const size_t& arg_i) const {
+            if (arg_i >= _size) {
+                throw std::out_of_range("ArgSpan: index out of range.");
+            }
+            return _data[arg_i];
+        }
+
+        const double& front() const {
+            return _data[0];
+        }
+
+        const double& back() const {
+            return _data[_size - 1];
+        }
+    };
+
+    typedef std::function<double(const ArgSpan& arg_x)> Builtin;
+
+    /**
+     * Arguments of a builtin applied to the records of a dataset at once.
+     * Each argument is a column with one value per record, and var(name)
+     * gives the column of a variable. Records whose active flag is zero do
+     * not take part; their results are discarded. A builtin may clear the
+     * flag of an active record to drop it after the current entry, as
+     * continue() does.
+     */
+    class BatchArgs {
+        size_t _size;
+        std::vector<const double*> _columns;
+        char* _active;
+        std::function<const double*(const std::string&)> _var;
+    public:
+
+        BatchArgs(const size_t& arg_size, const std::vector<const double*>& arg_columns, char* arg_active,
+                const std::function<const double*(const std::string&)>& arg_var)
+        : _size(arg_size), _columns(arg_columns), _active(arg_active), _var(arg_var) {
+        }
+
+        size_t size() const {
+            return _size;
+        }
+
+        size_t argNum() const {
+            return _columns.size();
+        }
+
+        const double* operator[](const size_t& arg_i) const {
+            return _columns[arg_i];
+        }
+
+        const double* at(const size_t& arg_i) const {
+            return _columns.at(arg_i);
+        }
+
+        char* active() const {
+            return _active;
+        }
+
+        const double* var(const std::string& arg_name) const {
+            return _var(arg_name);
+        }
+    };
+
+    typedef std::function<void(const BatchArgs& arg_x, double* arg_result)> BatchBuiltin;
+
+    /**
+     * Entry of the function table. Either a builtin registered by setFunc
+     * or a user-defined function whose body is a compiled program. A builtin
+     * may also have a batch version working on whole columns, declare its
+     * effect and the variables it reads and assigns and have a native form;
+     * see Evaluator::setEffect, Evaluator::setReads, Evaluator::setWrites
+     * and Evaluator::setNative.
+     */
+    struct Function {
+        int argNum = 0;
+        Builtin builtin;
+        std::shared_ptr<const Program> body;
+        BatchBuiltin batch;
+        char effect = 'A';
+        std::vector<int32_t> reads, writes;
+        std::string native, nativeType;
+        void (*nativePtr)() = nullptr;
+
+        bool isSet() const {
+            return builtin || body;
+        }
+
+        bool accepts(const size_t& arg_argNum) const {
+            return argNum == (int) arg_argNum || (argNum <= 0 && (size_t) - argNum <= arg_argNum);
+        }
+    };
+
+    class ColumnEvaluator;
+    class Optimizer;
+    class NativeModel;
+
     class Evaluator {
+        friend class ColumnEvaluator;
+        friend class Optimizer;
+        friend class NativeModel;
     protected:
-        std::unordered_map<std::string, double> _constants;
-        std::unordered_map<std::string, std::pair<size_t, std::function<double(const std::vector<double>& arg_x)> >> _functions;
+        SymbolTable _vars, _funcs;
+        std::vector<double> _frame;
+        std::vector<char> _isSet;
+        std::deque<Function> _funcTable;
+        std::vector<double> _regs;
+        std::vector<std::vector<double>> _retiredRegs;
+        size_t _regTop;
+        Profiler* _profiler;
+
+        void _fitFrame() {
+            if (_frame.size() < _vars.size()) {
+                _frame.resize(_vars.size(), std::nan(""));
+                _isSet.resize(_vars.size(), false);
+            }
+        }
+
+        double _loadUnset(const int32_t& arg_slot);
+
+        double _call(const int32_t& arg_func, const double* arg_x, const size_t& arg_argNum);
+
+        static double _nativeLoad(NativeHost* arg_host, int32_t arg_slot);
+
+        static double _nativeCall(NativeHost* arg_host, int32_t arg_func, const double* arg_x, size_t arg_argNum);
+
+        void _define(const FuncDefinition& arg_def);
+
+        static BatchBuiltin _elementwise(const Builtin& arg_func);
 
-        static double _sqrt(const std::vector<double>& arg_x) {
+        static double _sqrt(const ArgSpan& arg_x) {
             return sqrt(arg_x.front());
         };
 
-        static double _max(const std::vector<double>& arg_x) {
+        static double _max(const ArgSpan& arg_x) {
             return *std::max_element(arg_x.begin(), arg_x.end());
         };
 
-        static double _min(const std::vector<double>& arg_x) {
+        static double _min(const ArgSpan& arg_x) {
             return *std::min_element(arg_x.begin(), arg_x.end());
         };
 
-        static double _pow(const std::vector<double>& arg_x) {
+        static double _pow(const ArgSpan& arg_x) {
             return pow(arg_x.at(0), arg_x.at(1));
         };
 
-        static double _exp(const std::vector<double>& arg_x) {
+        static double _exp(const ArgSpan& arg_x) {
             return exp(arg_x.front());
         };
 
-        static double _log(const std::vector<double>& arg_x) {
+        static double _log(const ArgSpan& arg_x) {
             return log(arg_x.front());
         };
 
-        static double _log10(const std::vector<double>& arg_x) {
+        static double _log10(const ArgSpan& arg_x) {
             return log10(arg_x.front());
         };
 
-        static double _sin(const std::vector<double>& arg_x) {
+        static double _sin(const ArgSpan& arg_x) {
             return sin(arg_x.front());
         };
 
-        static double _cos(const std::vector<double>& arg_x) {
+        static double _cos(const ArgSpan& arg_x) {
             return cos(arg_x.front());
         };
 
-        static double _tan(const std::vector<double>& arg_x) {
+        static double _tan(const ArgSpan& arg_x) {
             return tan(arg_x.front());
         };
 
-        static double _abs(const std::vector<double>& arg_x) {
+        static double _abs(const ArgSpan& arg_x) {
             return fabs(arg_x.front());
         };
 
-        static double _asin(const std::vector<double>& arg_x) {
+        static double _asin(const ArgSpan& arg_x) {
             return asin(arg_x.front());
         };
 
-        static double _acos(const std::vector<double>& arg_x) {
+        static double _acos(const ArgSpan& arg_x) {
             return acos(arg_x.front());
         };
 
-        static double _atan(const std::vector<double>& arg_x) {
+        static double _atan(const ArgSpan& arg_x) {
             return atan(arg_x.front());
         };
 
-        static double _eval(const std::vector<double>& arg_x) {
+        static double _eval(const ArgSpan& arg_x) {
             return arg_x.back();
         };
 
-        static double _exit(const std::vector<double>& arg_x) {
+        static double _exit(const ArgSpan& arg_x) {
             exit(0);
             return 0.;
         }
@@ -333,23 +495,130 @@ namespace ASTReader {
         Evaluator();
 
         void setConst(const std::string& arg_name, const double& arg_val) {
-            _constants[arg_name] = arg_val;
+            setSlot(_vars.intern(arg_name), arg_val);
+        }
+
+        void setSlot(const int32_t& arg_slot, const double& arg_val) {
+            _fitFrame();
+            _frame[arg_slot] = arg_val;
+            _isSet[arg_slot] = true;
+        }
+
+        int32_t getSlot(const std::string& arg_name) {
+            return _vars.intern(arg_name);
+        }
+
+        /**
+         * Reads the variable in arg_slot as a script would, but without
+         * looking up its name; for builtins that read variables by name.
+         */
+        double load(const int32_t& arg_slot) {
+            return (size_t) arg_slot < _isSet.size() && _isSet[arg_slot] ? _frame[arg_slot] : _loadUnset(arg_slot);
+        }
+
+        SymbolTable& vars() {
+            return _vars;
+        }
+
+        SymbolTable& funcs() {
+            return _funcs;
         }
 
-        void setFunc(const std::string& arg_name, const int& arg_argNum, const std::function<double(const std::vector<double>& arg_x)>& arg_func) {
-            _functions[arg_name] = std::pair<int, std::function<double(const std::vector<double>)>>(arg_argNum, arg_func);
+        const SymbolTable& funcs() const {
+            return _funcs;
+        }
+
+        /**
+         * Times every builtin call into arg_profiler, or stops timing when it
+         * is null. The profiler is not taken over by adopt.
+         */
+        void setProfiler(Profiler* arg_profiler) {
+            _profiler = arg_profiler;
+        }
+
+        void setFunc(const std::string& arg_name, const int& arg_argNum, const Builtin& arg_func) {
+            int32_t func = _funcs.intern(arg_name);
+            if (_funcTable.size() <= (size_t) func) {
+                _funcTable.resize(func + 1);
+            }
+            _funcTable[func] = Function{arg_argNum, arg_func, nullptr};
+        }
+
+        void setFunc(const std::string& arg_name, const int& arg_argNum, const Builtin& arg_func, const BatchBuiltin& arg_batch) {
+            setFunc(arg_name, arg_argNum, arg_func);
+            _funcTable[_funcs.find(arg_name)].batch = arg_batch;
+        }
+
+        /**
+         * Declares what a builtin does besides returning its value: 'P'
+         * nothing, the value depending on the arguments alone, 'N' no
+         * assignment to any variable, or 'A' anything, the default. Calls
+         * of 'P' builtins may be folded and shared by the Optimizer.
+         */
+        void setEffect(const std::string& arg_name, const char& arg_effect) {
+            _funcTable.at(_funcs.find(arg_name)).effect = arg_effect;
+        }
+
+        /**
+         * Declares the variables the builtin arg_name reads, through
+         * BatchArgs::var in its batch version, so that
+         * ColumnEvaluator::prepare can check that every record has set them.
+         */
+        void setReads(const std::string& arg_name, const std::vector<std::string>& arg_vars) {
+            Function& func = _funcTable.at(_funcs.find(arg_name));
+            func.reads.clear();
+            for (const auto& var : arg_vars) {
+                func.reads.emplace_back(_vars.intern(var));
+            }
+        }
+
+        /**
+         * Declares the variables that the builtin arg_name of effect 'A'
+         * assigns, when these are all it assigns, so that
+         * Optimizer::carriesState can tell the datasets apart.
+         */
+        void setWrites(const std::string& arg_name, const std::vector<std::string>& arg_vars) {
+            Function& func = _funcTable.at(_funcs.find(arg_name));
+            func.writes.clear();
+            for (const auto& var : arg_vars) {
+                func.writes.emplace_back(_vars.intern(var));
+            }
+        }
+
+        /**
+         * Lets NativeModel compile calls of the builtin arg_name into the C++
+         * expression arg_expr, where $0, $1, ... stand for the arguments and
+         * ${NAME} for the variable NAME. A builtin outside the standard
+         * library is given as arg_ptr, a function of type arg_type, and
+         * written $f.
+         */
+        void setNative(const std::string& arg_name, const std::string& arg_expr, const std::string& arg_type = "", void (*arg_ptr)() = nullptr) {
+            Function& func = _funcTable.at(_funcs.find(arg_name));
+            func.native = arg_expr;
+            func.nativeType = arg_type;
+            func.nativePtr = arg_ptr;
         }
 
         void eraseConst(const std::string& arg_name) {
-            _constants.erase(arg_name);
+            int32_t slot = _vars.find(arg_name);
+            if (slot >= 0 && slot < (int32_t) _isSet.size()) {
+                _isSet[slot] = false;
+            }
         }
 
         void eraseFunc(const std::string& arg_name) {
-            _functions.erase(arg_name);
+            int32_t func = _funcs.find(arg_name);
+            if (func >= 0 && (size_t) func < _funcTable.size()) {
+                _funcTable[func] = Function();
+            }
         }
 
         const double& getConst(const std::string& arg_name) const {
-            return _constants.at(arg_name);
+            int32_t slot = _vars.find(arg_name);
+            if (slot < 0 || slot >= (int32_t) _isSet.size() || !_isSet[slot]) {
+                throw std::out_of_range("Constant not found. (" + arg_name + ")");
+            }
+            return _frame[slot];
         }
 
         double operator()(const double& arg_ast) {
@@ -429,6 +698,29 @@ namespace ASTReader {
             return boost::apply_visitor(*this, arg_ast);
         }
 
+        double execute(const Program& arg_prog, const double* arg_x = nullptr, const size_t& arg_argNum = 0);
+
+        /**
+         * Calls a builtin or a user-defined function as a script would.
+         */
+        double call(const int32_t& arg_func, const double* arg_x, const size_t& arg_argNum) {
+            return _call(arg_func, arg_x, arg_argNum);
+        }
+
+        void adopt(const Evaluator& arg_master);
+
+        /**
+         * Sets the variables back to the values of arg_master, which this
+         * evaluator has adopted, and unsets those of arg_slots.
+         */
+        void restore(const Evaluator& arg_master, const std::vector<int32_t>& arg_slots);
+
+        /**
+         * Appends the variables of arg_slots that are set to arg_vals, with
+         * their values.
+         */
+        void collect(const std::vector<int32_t>& arg_slots, std::vector<std::pair<int32_t, double>>& arg_vals) const;
+
     };
 
 }
@@ -9,39 +9,249 @@
 #define INTERPRETER_H
 
 #include "evaluator.h"
+#include "column_evaluator.h"
+#include "native_model.h"
+#include "optimizer.h"
+#include "output_sink.h"
 #include "parser.h"
+#include "record_reader.h"
+#include "rg_data.h"
+#include "rge_solver.h"
+#include "script_cache.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <deque>
+#include <exception>
 #include <iostream>
+#include <sstream>
 
 class Interpreter {
 protected:
     std::istream& _is;
     std::ostream& _os;
     ASTReader::Evaluator _eval;
-    std::vector<AST::Expression> _begRoutine, _mainRoutine, _endRoutine, _finRoutine;
+    ASTReader::ColumnEvaluator _columnEval;
+    std::vector<ASTReader::Program> _begRoutine, _mainRoutine, _endRoutine, _finRoutine;
     char _section;
     std::string _recordDelim, _datasetDelim, _outputDelim;
     std::vector<std::string> _recordVarNames, _datasetVarNames;
+    std::vector<int32_t> _recordVarSlots, _datasetVarSlots;
     std::unordered_map<std::string, std::string> _strings;
     std::unordered_map<std::string, std::vector<std::string>> _lists;
     bool _break, _continue;
     std::vector<std::string> _printStr;
 
-    void _executeAST(std::vector<AST::Expression>& arg_asts);
+    /**
+     * A dataset to be run by a worker. Records are stored row by row, with
+     * their line numbers and stream positions for the error raised by
+     * records after break(). Their texts are kept only if the input cannot
+     * seek.
+     */
+    struct _DatasetTask {
+        std::vector<int32_t> datasetVarSlots, recordVarSlots;
+        std::vector<double> datasetVals, recordVals;
+        std::vector<int> recordLines;
+        std::vector<std::streamoff> recordOffsets;
+        std::vector<size_t> recordEnds;
+        std::string recordText;
+    };
+
+    /**
+     * What a worker gives back. assigned are the variables the dataset
+     * assigned with their last values. breakLine is the line of the first
+     * record left after break(), if any, and breakOffset its stream
+     * position, or -1 with breakText its text.
+     */
+    struct _DatasetResult {
+        std::string output;
+        std::exception_ptr error;
+        std::vector<std::pair<int32_t, double>> assigned;
+        int breakLine;
+        std::streamoff breakOffset;
+        std::string breakText;
+    };
 
-    void _beginFunc(const std::vector<std::string>& arg_varNames, const std::vector<double>& arg_secVals);
+    /**
+     * An interpreter with its own output buffer. Used both for the workers
+     * and for the read-only snapshot of the state they start each dataset
+     * from, which also holds the variables a dataset may assign. A
+     * snapshot without interpreter means that the datasets carry state
+     * from one to the next and are run serially.
+     */
+    struct _Worker {
+        std::ostringstream os;
+        std::unique_ptr<Interpreter> interp;
+        std::shared_ptr<const _Worker> adopted;
+        std::vector<int32_t> assigned;
+    };
 
-    void _mainFunc(const std::vector<std::string>& arg_varNames, const std::vector<double>& arg_recordVals);
+    // The pool is declared after the workers, so that it is destroyed
+    // first and the jobs still queued after an error return before the
+    // workers go.
+    std::vector<std::unique_ptr<_Worker>> _workers;
+    std::unique_ptr<ThreadPool> _pool;
+    std::shared_ptr<const _Worker> _snapshot;
+    std::deque<std::future<_DatasetResult>> _pending;
+    // Set once a dataset fails or calls exit(), so that the datasets still
+    // queued are skipped.
+    std::atomic<bool> _stopped;
+    // Whether the current dataset is run by a worker.
+    bool _isParallel;
+    std::vector<std::shared_ptr<const RGData>> _rgData;
+    RGDataWriter* _writer;
+    _DatasetTask _task;
+    bool _columnar;
+    char _columnMode;
+    std::unique_ptr<Profiler> _profiler;
+    int _lineNum;
+    std::function<void(const ASTReader::ArgSpan&)> _printSink;
+    std::string _cacheDir;
+    std::string _modelPath;
+    char _modelMode;
+    std::unique_ptr<RecordReader> _recordReader;
+    std::vector<double> _recordVals;
+    std::unique_ptr<ScriptCache> _recording;
+    std::unique_ptr<OutputSink> _output;
+    std::vector<std::string> _rgVarNames, _rgBetaNames;
+    std::string _rgScale;
 
-    void _endFunc() {
-        _executeAST(_endRoutine);
-    }
+    /**
+     * Records requested by rge() in [BEGIN_ROUTINE], generated at the end
+     * of the dataset. None if nPoints is zero.
+     */
+    struct _RGRun {
+        double scaleBeg, scaleEnd, tolerance;
+        size_t nPoints;
+    } _rgRun;
+
+    /**
+     * An entry of [SCAN]: the values of a dataset variable, given by
+     * grid(), range() or values(), or an lhs() axis with its bounds, its
+     * number of points and its seed.
+     */
+    struct _ScanAxis {
+        std::string var;
+        char kind;
+        std::vector<double> vals;
+    };
+    std::vector<_ScanAxis> _scanAxes;
+
+    /**
+     * Number of lines of [BEGIN_ROUTINE], [MAIN_ROUTINE], [END_ROUTINE]
+     * and [FINALIZE] already optimized, and what was done to them.
+     */
+    size_t _nOptimized[4];
+    std::vector<std::string> _explanation;
+
+    /**
+     * The routine lines as compiled, to optimize them again when
+     * [INITIALIZE] replaces a builtin the optimizer may have relied on, and
+     * the functions that the lines of [INITIALIZE] define.
+     */
+    std::vector<ASTReader::Program> _unoptimized[4];
+    std::vector<char> _initDefined;
+
+    /**
+     * [MAIN_ROUTINE] as run per record, without the work moved into
+     * _perDataset, which is run after [BEGIN_ROUTINE]. _nHoisted is the
+     * number of lines of [MAIN_ROUTINE] they were made from, zero to
+     * make them again.
+     */
+    std::vector<ASTReader::Program> _perRecord, _perDataset;
+    size_t _nHoisted;
+    std::vector<std::string> _hoistExplanation;
+
+    void _executeAST(std::vector<ASTReader::Program>& arg_progs);
+
+    /**
+     * Optimizes the routine lines added since the last call, before they
+     * are first run.
+     */
+    void _optimize();
+
+    /**
+     * Flags the functions that the routines or [INITIALIZE] may define.
+     */
+    void _findDefinitions(std::vector<char>& arg_isDefined) const;
+
+    /**
+     * Makes _perRecord and _perDataset from [MAIN_ROUTINE], with the
+     * variables set by now.
+     */
+    void _hoist(const std::vector<int32_t>& arg_datasetSlots);
+
+    /**
+     * The variables given per record, also by rge().
+     */
+    std::vector<int32_t> _recordSlots();
+
+    void _beginFunc(const std::vector<int32_t>& arg_varSlots, const std::vector<double>& arg_secVals);
+
+    void _mainFunc(const std::vector<int32_t>& arg_varSlots, const std::vector<double>& arg_recordVals);
+
+    void _mainColumns(const std::vector<int32_t>& arg_varSlots, const std::vector<const double*>& arg_columns, const size_t& arg_nRecords);
+
+    void _getSlots(const std::vector<std::string>& arg_names, std::vector<int32_t>& arg_slots);
+
+    void _endFunc();
+
+    /**
+     * Evolves RG_VARS from their current values with RG_BETAS and runs
+     * [MAIN_ROUTINE] on each of the records requested by rge().
+     */
+    void _runRGE();
 
     void _finFunc() {
-        for (auto& ast : _finRoutine) {
-            _eval(ast);
+        if (_writer) {
+            return;
+        }
+        _drain();
+        _optimize();
+        for (auto& prog : _finRoutine) {
+            Profiler::Scope scope(_profiler ? _profiler->line(prog.line) : nullptr);
+            _eval.execute(prog);
         }
+        _output->flush();
     }
 
+    virtual std::unique_ptr<Interpreter> _clone(std::ostream& arg_os) const {
+        return std::unique_ptr<Interpreter>(new Interpreter(_is, arg_os));
+    }
+
+    void _adopt(const Interpreter& arg_master);
+
+    /**
+     * Whether the datasets are run by the workers, which they are with
+     * setJobs unless a dataset may read what the ones before it assigned.
+     * Makes the snapshot if needed.
+     */
+    bool _runsParallel(const std::vector<int32_t>& arg_datasetSlots);
+
+    void _dispatch();
+
+    void _emit(bool arg_wait);
+
+    void _drain();
+
+    _DatasetResult _runDataset(const _DatasetTask& arg_task, const _Worker& arg_snapshot);
+
+    bool _addRoutine(ASTReader::Program&& arg_prog);
+
+    void _runInit(const ASTReader::Program& arg_prog, const std::string& arg_text);
+
+    /**
+     * Appends an action to the script cache being recorded, if any.
+     */
+    void _record(const char& arg_type, const std::string& arg_name, const std::string& arg_text, const std::vector<std::string>& arg_list = {}, const ASTReader::Program& arg_prog = ASTReader::Program());
+
+    void _replay(const ScriptCache& arg_cache);
+
+    /**
+     * Compiles the routines into the model, or lets them run it, according
+     * to _modelMode: 'C' compile, 'L' load or 'N' none.
+     */
+    void _useModel(const std::string& arg_key);
+
     template<class DataType>
     void _getData(std::unordered_map<std::string, DataType>& arg_map, const std::string& arg_name, DataType& arg_result);
 
@@ -49,12 +259,29 @@ protected:
 
     bool _readInitSec(const std::string& arg_buf);
 
-    bool _readDataSec(const std::string& arg_buf);
+    /**
+     * Reads a record from [arg_first, arg_last) and runs it. Returns false
+     * if the line is not a list of numbers. [arg_textFirst, arg_textLast)
+     * is the line as written, arg_line its number and arg_offset its stream
+     * position, for errors.
+     */
+    bool _readDataSec(const char* arg_first, const char* arg_last, const char* arg_textFirst, const char* arg_textLast, const int& arg_line, const std::streamoff& arg_offset);
 
     bool _readOtherSec(const std::string& arg_buf);
 
     bool _readDatasetVar(const std::string& arg_secVar);
 
+    bool _readScanSec(const std::string& arg_buf);
+
+    /**
+     * Runs a dataset without records for each point of [SCAN], as if each
+     * were given by a [DATASET] section. The last one is left open, to be
+     * ended by the next section or at the end of the input.
+     */
+    void _runScan();
+
+    void _readRGData(const RGData& arg_data);
+
 public:
 
     class InterpreterError : public std::runtime_error {
@@ -62,38 +289,90 @@ public:
         std::string _expected;
         std::string _original;
         bool _isSet;
+        bool _isReported;
     public:
 
-        InterpreterError(const std::string& str) : std::runtime_error(str), _isSet(false) {
+        InterpreterError(const std::string& str) : std::runtime_error(str), _isSet(false), _isReported(false) {
         }
 
         InterpreterError(const boost::spirit::x3::expectation_failure<std::string::iterator>& arg_e, std::string& arg_in)
-        : std::runtime_error("Parser: Expectation Error."), _pos(std::distance(arg_in.begin(), arg_e.where())), _expected(arg_e.which()), _original(arg_in), _isSet(true) {
+        : std::runtime_error("Parser: Expectation Error."), _pos(std::distance(arg_in.begin(), arg_e.where())), _expected(arg_e.which()), _original(arg_in), _isSet(true), _isReported(false) {
         }
 
         void errorMsg(std::ostream& arg_out) const;
+
+        /**
+         * Whether the error was already written to the output with its
+         * line, as for records after break() run by a worker.
+         */
+        bool isReported() const {
+            return _isReported;
+        }
+
+        void setReported() {
+            _isReported = true;
+        }
+    };
+
+    /**
+     * Thrown by exit() in a routine. analyze() returns there after the
+     * output is flushed, while runDataset and finalize pass it on.
+     */
+    struct Exit {
     };
 
     Interpreter(std::istream& arg_is, std::ostream& arg_os);
 
+    virtual ~Interpreter() {
+    }
+
     void evaluateAST(AST::Expression& arg_ast) {
         _eval(arg_ast);
     }
 
     void setConst(const std::string& arg_name, const double& arg_val) {
         _eval.setConst(arg_name, arg_val);
+        _snapshot.reset();
     }
 
-    void setFunc(const std::string& arg_name, const int& arg_argNum, const std::function<double(const std::vector<double>& arg_x)>& arg_func) {
+    void setFunc(const std::string& arg_name, const int& arg_argNum, const ASTReader::Builtin& arg_func) {
         _eval.setFunc(arg_name, arg_argNum, arg_func);
+        _snapshot.reset();
+    }
+
+    void setFunc(const std::string& arg_name, const int& arg_argNum, const ASTReader::Builtin& arg_func, const ASTReader::BatchBuiltin& arg_batch) {
+        _eval.setFunc(arg_name, arg_argNum, arg_func, arg_batch);
+        _snapshot.reset();
+    }
+
+    void setEffect(const std::string& arg_name, const char& arg_effect) {
+        _eval.setEffect(arg_name, arg_effect);
+        _snapshot.reset();
+    }
+
+    void setReads(const std::string& arg_name, const std::vector<std::string>& arg_vars) {
+        _eval.setReads(arg_name, arg_vars);
+        _snapshot.reset();
+    }
+
+    void setWrites(const std::string& arg_name, const std::vector<std::string>& arg_vars) {
+        _eval.setWrites(arg_name, arg_vars);
+        _snapshot.reset();
+    }
+
+    void setNative(const std::string& arg_name, const std::string& arg_expr, const std::string& arg_type = "", void (*arg_ptr)() = nullptr) {
+        _eval.setNative(arg_name, arg_expr, arg_type, arg_ptr);
+        _snapshot.reset();
     }
 
     void eraseConst(const std::string& arg_name) {
         _eval.eraseConst(arg_name);
+        _snapshot.reset();
     }
 
     void eraseFunc(const std::string& arg_name) {
         _eval.eraseFunc(arg_name);
+        _snapshot.reset();
     }
 
     const double& getConst(const std::string& arg_name) const {
@@ -104,8 +383,149 @@ public:
         _outputDelim = arg_delim;
     }
 
+    /**
+     * Runs the datasets on arg_jobs worker threads. Each dataset starts
+     * from a copy of the state left by the preceding sections, the output
+     * and the variables assigned by the datasets are taken in their
+     * original order, and datasets that may read what the ones before them
+     * assigned are run serially.
+     */
+    void setJobs(const size_t& arg_jobs);
+
+    /**
+     * Appends binary RG data, which is analyzed after the input stream.
+     */
+    void addRGData(const std::shared_ptr<const RGData>& arg_data) {
+        _rgData.emplace_back(arg_data);
+    }
+
+    /**
+     * Runs MAIN_ROUTINE over all the records of a dataset at once when no
+     * record depends on another, and record by record otherwise.
+     */
+    void setColumnar(const bool& arg_columnar) {
+        _columnar = arg_columnar;
+        _snapshot.reset();
+    }
+
+    /**
+     * Times the script lines, the builtins and the parsing of [DATASET]
+     * sections, also on the worker threads.
+     */
+    void setProfile(const bool& arg_profile);
+
+    /**
+     * Prints the times collected since setProfile.
+     */
+    void printProfile(std::ostream& arg_os) const;
+
+    /**
+     * Prints the constants folded, the subexpressions shared and those
+     * hoisted out of the records in the routines, with their lines.
+     */
+    void printExplain(std::ostream& arg_os) const {
+        for (const auto& line : _explanation) {
+            arg_os << line << std::endl;
+        }
+        // With -j N, [MAIN_ROUTINE] is hoisted by the workers, the last
+        // time by the one that saw the most lines.
+        const Interpreter* hoisting = this;
+        for (const auto& worker : _workers) {
+            if (worker->interp->_nHoisted > hoisting->_nHoisted) {
+                hoisting = worker->interp.get();
+            }
+        }
+        for (const auto& line : hoisting->_hoistExplanation) {
+            arg_os << line << std::endl;
+        }
+    }
+
+    /**
+     * Passes the arguments of every print call to arg_sink instead of
+     * writing them to the output stream. An empty function restores the
+     * output stream.
+     */
+    void setPrintSink(const std::function<void(const ASTReader::ArgSpan&)>& arg_sink) {
+        _printSink = arg_sink;
+    }
+
+    /**
+     * Writes the print rows as arg_format, "text", "csv" or "binary"; see
+     * OutputSink. Throws OutputSink::OutputSinkError for other formats.
+     */
+    void setOutputFormat(const std::string& arg_format) {
+        _output = OutputSink::create(arg_format, _os);
+        _snapshot.reset();
+    }
+
+    /**
+     * Stores the compiled script part of the input, everything before the
+     * first [DATASET], in arg_dir and reuses it when the same script is
+     * loaded again, skipping its parsing. Empty to disable.
+     */
+    void setCacheDir(const std::string& arg_dir) {
+        _cacheDir = arg_dir;
+    }
+
+    /**
+     * Runs [BEGIN_ROUTINE], [MAIN_ROUTINE] and [END_ROUTINE] with the
+     * native model arg_path made by compileModel from the same script. A
+     * model that does not fit is left out with a warning, and the script
+     * interpreted. Empty to disable.
+     */
+    void setModel(const std::string& arg_path) {
+        _modelPath = arg_path;
+        _modelMode = arg_path.empty() ? 'N' : 'L';
+    }
+
+    /**
+     * Reads the script part of the input stream, running [INITIALIZE], and
+     * compiles its routines into the native model arg_path; see
+     * NativeModel.
+     */
+    void compileModel(const std::string& arg_path) {
+        _modelPath = arg_path;
+        _modelMode = 'C';
+        load();
+    }
+
+    const std::vector<std::string>& datasetVarNames() {
+        _getData(_lists, "DATASET_VARS", _datasetVarNames);
+        return _datasetVarNames;
+    }
+
+    const std::vector<std::string>& recordVarNames() {
+        _getData(_lists, "RECORD_VARS", _recordVarNames);
+        return _recordVarNames;
+    }
+
+    /**
+     * Reads and compiles the sections of the input stream, running
+     * [INITIALIZE] and any [DATASET] in it, but neither the final
+     * [END_ROUTINE] nor [FINALIZE].
+     */
+    void load();
+
+    /**
+     * Runs [BEGIN_ROUTINE], [MAIN_ROUTINE] for each of arg_nRecords records
+     * stored row by row in arg_records, and [END_ROUTINE], as for a
+     * [DATASET] section. Runs on the calling thread.
+     */
+    void runDataset(const std::vector<double>& arg_datasetVals, const double* arg_records, const size_t& arg_nRecords);
+
+    /**
+     * Runs [FINALIZE].
+     */
+    void finalize();
+
     void analyze();
 
+    /**
+     * Reads the input stream without running any routine and writes its
+     * datasets as binary RG data.
+     */
+    void convert(RGDataWriter& arg_writer);
+
     void interactive();
 };
 
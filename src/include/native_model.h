@@ -0,0 +1,119 @@
+/**
+ * @file native_model.h
+ * @brief Routines compiled ahead of time into shared objects
+ * @date Created on: 2026/10/17, 23:58
+ */
+
+#ifndef NATIVE_MODEL_H
+#define NATIVE_MODEL_H
+
+#include "evaluator.h"
+#include <stdexcept>
+
+namespace ASTReader {
+
+    /**
+     * The routines of a script translated into C++, one function per line,
+     * and built into a shared object by the system compiler. Variables are
+     * read and written in the frame of the evaluator by slot, builtins with
+     * a native form are called directly and the others through the
+     * evaluator; see Evaluator::setNative. The instructions are translated
+     * one by one without contraction into FMAs, so that the results are the
+     * same as those of the bytecode.
+     *
+     * A model only fits the script it was compiled from, which is checked
+     * by the key of the script part; see ScriptCache::key. A line defining
+     * a function is left to the evaluator. Loaded objects are never
+     * unloaded, as their code is referenced by the programs.
+     */
+    class NativeModel {
+    public:
+        static const int32_t abi = 1;
+
+        class NativeModelError : public std::runtime_error {
+        public:
+
+            NativeModelError(const std::string& str) : std::runtime_error(str) {
+            }
+        };
+
+        /**
+         * A routine as a section code, 'B', 'M' or 'E', and its lines.
+         */
+        typedef std::vector<std::pair<char, std::vector<Program>*>> Routines;
+
+    protected:
+
+        /**
+         * The layout of what the generated code exports.
+         */
+        struct _Line {
+            char section;
+            int32_t index, line;
+            double (*run)(NativeHost* arg_host);
+        };
+
+        struct _Info {
+            int32_t abi;
+            const char* key;
+            int32_t nVars;
+            const char* const* vars;
+            int32_t nFuncs;
+            const char* const* funcs;
+            int32_t nNatives;
+            const char* const* natives;
+            const char* const* nativeExprs;
+            const char* const* nativeTypes;
+            void (*bind)(void (*const* arg_ptrs)());
+            int32_t nLines;
+            const _Line* lines;
+        };
+
+        const _Info* _info;
+
+        /**
+         * The body of the function for arg_prog, or an empty string if it
+         * cannot be compiled. Builtins called in their native form are
+         * added to arg_natives, and $f stands for f<k>, k being the position
+         * in arg_natives.
+         */
+        static std::string _translate(const Evaluator& arg_eval, const Program& arg_prog, const std::vector<char>& arg_isDefined, std::vector<int32_t>& arg_natives);
+
+    public:
+
+        /**
+         * Loads the shared object arg_path. Throws NativeModelError if it
+         * cannot be loaded or is not a model of this version.
+         */
+        explicit NativeModel(const std::string& arg_path);
+
+        /**
+         * The C++ source of a model of arg_routines, for the script part
+         * with the key arg_key.
+         */
+        static std::string generate(const Evaluator& arg_eval, const Routines& arg_routines, const std::string& arg_key);
+
+        /**
+         * Builds arg_source into the shared object arg_path with the
+         * compiler in the environment variable CXX, or the one ELVAS was
+         * built with. Throws NativeModelError if no compiler can build it.
+         */
+        static void build(const std::string& arg_source, const std::string& arg_path);
+
+        /**
+         * Lets the lines of arg_routines run the native code. Throws
+         * NativeModelError, changing nothing, if the model was compiled
+         * from another script than arg_key or for other builtins.
+         */
+        void bind(const Evaluator& arg_eval, const Routines& arg_routines, const std::string& arg_key) const;
+
+        /**
+         * Number of lines compiled.
+         */
+        size_t size() const {
+            return _info->nLines;
+        }
+    };
+}
+
+#endif /* NATIVE_MODEL_H */
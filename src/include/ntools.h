@@ -15,6 +15,9 @@
 #include <cmath>
 #include <algorithm>
 #include <utility>
+#include <cfloat>
+#include <cstdint>
+#include <cstring>
 
 class NTools {
 public:
@@ -31,11 +34,62 @@ public:
     template<class Iter>
     static double integrateSIMP(Iter arg_yfirst, Iter arg_ylast, const double& arg_dx, int arg_even = 0);
 
+    /**
+     * Adaptive Simpson quadrature of arg_f over [arg_a, arg_b]. The interval
+     * is first split into arg_nPanels panels, each of which is bisected until
+     * the Richardson estimate of its error is within its share of
+     * arg_tol * |integral|. The number of evaluations of arg_f and the
+     * estimated absolute error are returned through arg_nEval and arg_error.
+     */
+    template<class Func>
+    static double integrateAdaptiveSIMP(Func&& arg_f, const double& arg_a, const double& arg_b, const double& arg_tol,
+            size_t& arg_nEval, double& arg_error, const int& arg_nPanels = 16, const int& arg_maxDepth = 20);
+
+    template<class Iter>
+    static double interpolateL2(Iter arg_it_first, Iter arg_it_last, const double& arg_x);
+
+    /**
+     * Quadratic interpolation like interpolateL2 for query points close to
+     * each other. The search resumes from the previous match in either
+     * direction, so a sweep over the whole table costs O(n) in total.
+     */
+    template<class Iter>
+    class CursorL2 {
+        Iter _first, _last, _cursor;
+        double _x;
+    public:
+
+        CursorL2(Iter arg_it_first, Iter arg_it_last) : _first(arg_it_first), _last(arg_it_last), _cursor(arg_it_first), _x(-INFINITY) {
+        }
+
+        double operator()(const double& arg_x);
+    };
+
     template<class Iter>
-    static double interpolateL2(Iter arg_it_first, Iter arg_it_last, const double& arg_x, const bool& arg_replaceFirst = false);
+    static CursorL2<Iter> cursorL2(Iter arg_it_first, Iter arg_it_last) {
+        return CursorL2<Iter>(arg_it_first, arg_it_last);
+    }
 
     template<class Number>
     static Number powInt(const Number& arg_base, const int32_t& arg_exp);
+
+    /**
+     * Logarithm and exponential without branches or library calls, so that
+     * loops over arrays vectorize. They follow fdlibm and agree with log and
+     * exp within an ulp, including the special values.
+     */
+    static double vecLog(const double& arg_x);
+
+    static double vecExp(const double& arg_x);
+
+private:
+
+    template<class Func>
+    static double _adaptiveSIMP(Func& arg_f, const double& arg_a, const double& arg_b, const double& arg_fa, const double& arg_fm,
+            const double& arg_fb, const double& arg_whole, const double& arg_tol, const int& arg_depth, size_t& arg_nEval, double& arg_error);
+
+    template<class Iter>
+    static double _interpolateL2At(Iter arg_it_first, Iter arg_it_last, Iter arg_it_match, const double& arg_x);
 };
 
 
@@ -75,12 +129,80 @@ double NTools::integrateSIMP(Iter arg_yfirst, Iter arg_ylast, const double& arg_
     return sum;
 }
 
+template<class Func>
+double NTools::integrateAdaptiveSIMP(Func&& arg_f, const double& arg_a, const double& arg_b, const double& arg_tol,
+        size_t& arg_nEval, double& arg_error, const int& arg_nPanels, const int& arg_maxDepth) {
+    if (!(arg_a < arg_b) || !(arg_tol > 0.) || arg_nPanels < 1) {
+        throw NtoolsError("Adaptive Simpson integrator: wrong inputs.");
+    }
+
+    size_t ysize = 2 * arg_nPanels + 1;
+    double dx = (arg_b - arg_a) / (ysize - 1);
+    std::vector<double> y(ysize);
+    for (size_t i = 0; i < ysize; i++) {
+        y[i] = arg_f(arg_a + dx * i);
+    }
+    arg_nEval = ysize;
+    arg_error = 0.;
+
+    std::vector<double> panels(arg_nPanels);
+    double coarse = 0.;
+    for (int i = 0; i < arg_nPanels; i++) {
+        panels[i] = (y[2 * i] + 4. * y[2 * i + 1] + y[2 * i + 2]) * dx / 3.;
+        coarse += panels[i];
+    }
+
+    double tol = arg_tol * fabs(coarse) / arg_nPanels;
+    double sum = 0.;
+    for (int i = 0; i < arg_nPanels; i++) {
+        sum += _adaptiveSIMP(arg_f, arg_a + dx * 2 * i, arg_a + dx * (2 * i + 2), y[2 * i], y[2 * i + 1], y[2 * i + 2],
+                panels[i], tol, arg_maxDepth, arg_nEval, arg_error);
+    }
+    return sum;
+}
+
+template<class Func>
+double NTools::_adaptiveSIMP(Func& arg_f, const double& arg_a, const double& arg_b, const double& arg_fa, const double& arg_fm,
+        const double& arg_fb, const double& arg_whole, const double& arg_tol, const int& arg_depth, size_t& arg_nEval, double& arg_error) {
+    double m = 0.5 * (arg_a + arg_b);
+    double flm = arg_f(0.5 * (arg_a + m)), frm = arg_f(0.5 * (m + arg_b));
+    arg_nEval += 2;
+    double left = (flm * 4. + arg_fa + arg_fm) * (m - arg_a) / 6.;
+    double right = (frm * 4. + arg_fm + arg_fb) * (arg_b - m) / 6.;
+    double delta = left + right - arg_whole;
+    if (arg_depth <= 0 || fabs(delta) <= 15. * arg_tol) {
+        arg_error += fabs(delta) / 15.;
+        return left + right + delta / 15.;
+    }
+    return _adaptiveSIMP(arg_f, arg_a, m, arg_fa, flm, arg_fm, left, 0.5 * arg_tol, arg_depth - 1, arg_nEval, arg_error)
+            + _adaptiveSIMP(arg_f, m, arg_b, arg_fm, frm, arg_fb, right, 0.5 * arg_tol, arg_depth - 1, arg_nEval, arg_error);
+}
+
 template<class Iter>
-double NTools::interpolateL2(Iter arg_it_first, Iter arg_it_last, const double& arg_x, const bool& arg_replaceFirst) {
+double NTools::interpolateL2(Iter arg_it_first, Iter arg_it_last, const double& arg_x) {
     auto it_match = std::lower_bound(arg_it_first, arg_it_last, arg_x, [](const auto& a, const double& b) {
         return a.first < b;
     });
+    return _interpolateL2At(arg_it_first, arg_it_last, it_match, arg_x);
+};
+
+template<class Iter>
+double NTools::CursorL2<Iter>::operator()(const double& arg_x) {
+    if (arg_x < _x) {
+        while (_cursor != _first && (_cursor - 1)->first >= arg_x) {
+            --_cursor;
+        }
+    }
+    _x = arg_x;
+    while (_cursor != _last && _cursor->first < arg_x) {
+        ++_cursor;
+    }
+    return _interpolateL2At(_first, _last, _cursor, arg_x);
+}
 
+template<class Iter>
+double NTools::_interpolateL2At(Iter arg_it_first, Iter arg_it_last, Iter arg_it_match, const double& arg_x) {
+    auto it_match = arg_it_match;
     if (it_match == arg_it_last) {
         if (fabs(arg_x - (it_match - 1)->first) > 0.1 * fabs((it_match - 1)->first - (it_match - 2)->first)) {
             throw NtoolsError("Interpolation: out of range (High).");
@@ -96,16 +218,13 @@ double NTools::interpolateL2(Iter arg_it_first, Iter arg_it_last, const double&
     } else if (it_match != arg_it_first + 1 && 2. * arg_x < (it_match->first + (it_match - 1)->first)) {
         --it_match;
     }
-    if (arg_replaceFirst) {
-        arg_it_first = it_match - 2;
-    }
 
     const double &x0 = (it_match - 1)->first, &x1 = (it_match)->first, &x2 = (it_match + 1)->first;
     const double &y0 = (it_match - 1)->second, &y1 = (it_match)->second, &y2 = (it_match + 1)->second;
     return (arg_x - x1) * (arg_x - x2) / ((x0 - x1) * (x0 - x2)) * y0
             + (arg_x - x0) * (arg_x - x2) / ((x1 - x0) * (x1 - x2)) * y1
             + (arg_x - x0) * (arg_x - x1) / ((x2 - x0) * (x2 - x1)) * y2;
-};
+}
 
 template<class Number>
 Number NTools::powInt(const Number& arg_base, const int32_t& arg_exp) {
@@ -123,5 +242,70 @@ Number NTools::powInt(const Number& arg_base, const int32_t& arg_exp) {
     return arg_exp > 0 ? result : 1. / result;
 }
 
+inline double NTools::vecLog(const double& arg_x) {
+    const double ln2Hi = 6.93147180369123816490e-01, ln2Lo = 1.90821492927058770002e-10;
+    const double lg1 = 6.666666666666735130e-01, lg2 = 3.999999999940941908e-01;
+    const double lg3 = 2.857142874366239149e-01, lg4 = 2.222219843214978396e-01;
+    const double lg5 = 1.818357216161805012e-01, lg6 = 1.531383769920937332e-01;
+    const double lg7 = 1.479819860511658591e-01;
+
+    bool isSubnormal = arg_x < DBL_MIN;
+    double x = arg_x * (isSubnormal ? 0x1p54 : 1.);
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof (bits));
+
+    // x = 2^k * m with m in [sqrt(2)/2, sqrt(2))
+    bits += 0x3ff0000000000000ULL - 0x3fe6a09e00000000ULL;
+    uint64_t kBits = 0x4330000000000000ULL | (bits >> 52);
+    bits = (bits & 0x000fffffffffffffULL) + 0x3fe6a09e00000000ULL;
+    double m, k;
+    memcpy(&m, &bits, sizeof (m));
+    memcpy(&k, &kBits, sizeof (k));
+    k -= 0x1p52 + 1023. + (isSubnormal ? 54. : 0.);
+
+    double f = m - 1.;
+    double hfsq = 0.5 * f * f;
+    double s = f / (2. + f);
+    double z = s * s;
+    double w = z * z;
+    double r = z * (lg1 + w * (lg3 + w * (lg5 + w * lg7))) + w * (lg2 + w * (lg4 + w * lg6));
+    double result = s * (hfsq + r) + k * ln2Lo - hfsq + f + k * ln2Hi;
+
+    result = arg_x > 0. ? result : (arg_x == 0. ? -INFINITY : NAN);
+    return arg_x < INFINITY ? result : arg_x;
+}
+
+inline double NTools::vecExp(const double& arg_x) {
+    const double ln2Hi = 6.93147180369123816490e-01, ln2Lo = 1.90821492927058770002e-10;
+    const double invLn2 = 1.44269504088896338700e+00;
+    const double p1 = 1.66666666666666019037e-01, p2 = -2.77777777770155933842e-03;
+    const double p3 = 6.61375632143793436117e-05, p4 = -1.65339022054652515390e-06;
+    const double p5 = 4.13813679705723846039e-08;
+
+    double x = std::min(std::max(arg_x, -750.), 710.);
+
+    // x = k ln2 + r with |r| <= ln2 / 2
+    double t = x * invLn2 + 0x1.8p52;
+    uint64_t tBits;
+    memcpy(&tBits, &t, sizeof (tBits));
+    double k = t - 0x1.8p52;
+    double hi = x - k * ln2Hi, lo = k * ln2Lo;
+    double r = hi - lo;
+    double rr = r * r;
+    double c = r - rr * (p1 + rr * (p2 + rr * (p3 + rr * (p4 + rr * p5))));
+    double result = 1. + (r * c / (2. - c) - lo + hi);
+
+    // 2^k is applied in two steps to reach the subnormal range
+    uint64_t k1 = ((tBits - 0x4338000000000000ULL + 2048) >> 1) - 1024;
+    uint64_t k2 = tBits - 0x4338000000000000ULL - k1;
+    uint64_t scaleBits1 = (k1 + 1023) << 52, scaleBits2 = (k2 + 1023) << 52;
+    double scale1, scale2;
+    memcpy(&scale1, &scaleBits1, sizeof (scale1));
+    memcpy(&scale2, &scaleBits2, sizeof (scale2));
+    result = result * scale1 * scale2;
+
+    return arg_x == arg_x ? result : arg_x;
+}
+
 #endif /* NTOOLS_H */
 
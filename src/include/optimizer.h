@@ -0,0 +1,162 @@
+/**
+ * @file optimizer.h
+ * @brief Constant folding, sharing of subexpressions and hoisting in routines
+ * @date Created on: 2026/10/17, 23:55
+ */
+
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "evaluator.h"
+#include <map>
+
+namespace ASTReader {
+
+    /**
+     * Rewrites the programs of a routine, one per line, in place.
+     *
+     * An operation on numbers and on the results of pure builtins, such as
+     * log(10), is replaced by its value. An operation on variables computed
+     * on every path of a line, such as g2^2, is stored in a hidden variable
+     * when the same operation on the same values comes again later in the
+     * routine, which then loads it instead. A value stops being the same
+     * when one of its variables is assigned, or when a builtin that may
+     * assign variables or a user-defined function is called; see
+     * Evaluator::setEffect. The results are the same bit for bit, as the
+     * operations are neither reordered nor reassociated.
+     *
+     * Function bodies are left as they are.
+     *
+     * Separately, the operations of [MAIN_ROUTINE] on values that do not
+     * change from record to record are moved out to be run once per
+     * dataset; see hoist.
+     */
+    class Optimizer {
+    public:
+
+        struct Report {
+            size_t nFolded = 0, nShared = 0, nRemoved = 0, nHoisted = 0;
+            std::vector<std::pair<int32_t, std::string>> notes;
+        };
+
+    protected:
+
+        /**
+         * A value of the routine: a number, a variable as last assigned, or
+         * an operation on other values. site is the first place where it is
+         * computed on every path, if any.
+         */
+        struct _Value {
+            bool isConst;
+            double num;
+            size_t prog, pc;
+            int32_t reg;
+            bool hasSite;
+        };
+
+        struct _Site {
+            size_t prog, pc;
+
+            bool operator<(const _Site& arg_site) const {
+                return prog != arg_site.prog ? prog < arg_site.prog : pc < arg_site.pc;
+            }
+        };
+
+        Evaluator& _eval;
+        const std::vector<char>& _isDefined;
+        std::vector<Program>& _progs;
+        std::map<std::vector<int64_t>, size_t> _index;
+        std::vector<_Value> _values;
+        std::vector<int64_t> _versions;
+        int64_t _epoch;
+        std::map<_Site, size_t> _sites, _uses;
+        std::map<_Site, std::pair<char, std::string>> _notes;
+        std::vector<std::vector<char>> _removed;
+        std::vector<char> _kinds;
+        Report _report;
+
+        Optimizer(Evaluator& arg_eval, std::vector<Program>& arg_progs, const std::vector<char>& arg_isDefined);
+
+        char _effect(const int32_t& arg_func, const size_t& arg_argNum) const;
+
+        size_t _value(const std::vector<int64_t>& arg_key, const bool& arg_isConst = false, const double& arg_num = 0.);
+
+        size_t _const(const double& arg_num);
+
+        void _remove(const size_t& arg_prog, const std::vector<size_t>& arg_tree, const size_t& arg_keep);
+
+        void _scan(const size_t& arg_prog);
+
+        void _rewrite(const size_t& arg_prog, const std::vector<int32_t>& arg_hidden);
+
+        /**
+         * Raises to arg_kind the variables that arg_progs may assign.
+         */
+        void _classify(const std::vector<Program>& arg_progs, const char& arg_kind);
+
+        void _hoist(const size_t& arg_prog, std::vector<Program>& arg_hoisted);
+
+        /**
+         * What a call of arg_func does to the variables as far as known: 'B'
+         * a builtin that reads and assigns those it declares, 'U' a
+         * user-defined function, which does what its body does, or 'A'
+         * anything.
+         */
+        char _callKind(const int32_t& arg_func, const size_t& arg_argNum) const;
+
+        /**
+         * Flags in arg_isAssigned the variables that arg_prog may assign.
+         * Returns false if it may assign any. arg_calling holds the
+         * user-defined functions being followed.
+         */
+        bool _findAssigned(const Program& arg_prog, std::vector<char>& arg_isAssigned, std::vector<int32_t>& arg_calling) const;
+
+        /**
+         * Whether arg_prog may read a variable of arg_isAssigned that is not
+         * in arg_isStored, the variables stored on every path so far, which
+         * is then updated to the end of arg_prog.
+         */
+        bool _readsEarly(const Program& arg_prog, const std::vector<char>& arg_isAssigned, std::vector<char>& arg_isStored, std::vector<int32_t>& arg_calling) const;
+
+    public:
+
+        /**
+         * Optimizes arg_progs from arg_first on, as lines of one routine.
+         * arg_isDefined flags the functions that a routine may define, whose
+         * builtins may be replaced at run time.
+         */
+        static Report optimize(Evaluator& arg_eval, std::vector<Program>& arg_progs, const size_t& arg_first, const std::vector<char>& arg_isDefined);
+
+        /**
+         * Moves the operations of arg_main, the lines of [MAIN_ROUTINE], that
+         * give the same value for all the records of a dataset into
+         * arg_hoisted, to be run once before the records. The variables of
+         * arg_recordSlots and those assigned in arg_main change per record,
+         * those of arg_datasetSlots and those assigned in arg_routines per
+         * dataset, and the others only once per run. Only the variables set
+         * by now are read in arg_hoisted.
+         */
+        static Report hoist(Evaluator& arg_eval, std::vector<Program>& arg_main, std::vector<Program>& arg_hoisted, const std::vector<const std::vector<Program>*>& arg_routines,
+                const std::vector<int32_t>& arg_datasetSlots, const std::vector<int32_t>& arg_recordSlots, const std::vector<char>& arg_isDefined);
+
+        /**
+         * Whether a dataset may read what the datasets before it assigned:
+         * a variable that arg_begin, arg_main or arg_end, the lines of
+         * [BEGIN_ROUTINE], [MAIN_ROUTINE] and [END_ROUTINE], may assign,
+         * read before the dataset assigns it. The variables of
+         * arg_datasetSlots are set before [BEGIN_ROUTINE], and those of
+         * arg_recordSlots before each run of [MAIN_ROUTINE], which may not
+         * run at all. If not, arg_assigned is set to the variables a dataset
+         * may assign, these included.
+         */
+        static bool carriesState(Evaluator& arg_eval, const std::vector<Program>& arg_begin, const std::vector<Program>& arg_main, const std::vector<Program>& arg_end,
+                const std::vector<int32_t>& arg_datasetSlots, const std::vector<int32_t>& arg_recordSlots, const std::vector<char>& arg_isDefined, std::vector<int32_t>& arg_assigned);
+
+        /**
+         * Flags in arg_isDefined the functions defined by arg_progs.
+         */
+        static void findDefinitions(const std::vector<Program>& arg_progs, std::vector<char>& arg_isDefined);
+    };
+}
+
+#endif /* OPTIMIZER_H */
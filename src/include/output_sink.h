@@ -0,0 +1,125 @@
+/**
+ * @file output_sink.h
+ * @brief Formats of what print writes
+ * @date Created on: 2026/10/17, 23:10
+ */
+
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+#include "evaluator.h"
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+/**
+ * Writes the rows of print and the texts of print("...") and [INITIALIZE]
+ * to a stream. A row is formatted into a buffer and written at once, and
+ * lines end with '\n' without flushing: the interpreter flushes the stream
+ * at the end of each dataset and of the input instead.
+ */
+class OutputSink {
+protected:
+    std::ostream& _os;
+    std::string _buf;
+
+public:
+
+    class OutputSinkError : public std::runtime_error {
+    public:
+
+        OutputSinkError(const std::string& str) : std::runtime_error(str) {
+        }
+    };
+
+    explicit OutputSink(std::ostream& arg_os) : _os(arg_os) {
+    }
+
+    virtual ~OutputSink() {
+    }
+
+    /**
+     * Creates the sink of arg_format, "text", "csv" or "binary".
+     */
+    static std::unique_ptr<OutputSink> create(const std::string& arg_format, std::ostream& arg_os);
+
+    /**
+     * The same sink writing to arg_os, for the worker threads.
+     */
+    virtual std::unique_ptr<OutputSink> clone(std::ostream& arg_os) const = 0;
+
+    /**
+     * Writes the arguments of a print call. arg_delim is OUTPUT_DELIM.
+     */
+    virtual void row(const ASTReader::ArgSpan& arg_vals, const std::string& arg_delim) = 0;
+
+    virtual void text(const std::string& arg_text) = 0;
+
+    void flush() {
+        _os.flush();
+    }
+};
+
+/**
+ * The output of operator<<: numbers take the precision and the float field
+ * of the stream, which are std::scientific and output_precision in ELVAS.
+ * They are formatted with std::to_chars where available, and by the stream
+ * itself for flags that to_chars does not cover.
+ */
+class TextSink : public OutputSink {
+public:
+
+    explicit TextSink(std::ostream& arg_os) : OutputSink(arg_os) {
+    }
+
+    std::unique_ptr<OutputSink> clone(std::ostream& arg_os) const override {
+        return std::unique_ptr<OutputSink>(new TextSink(arg_os));
+    }
+
+    void row(const ASTReader::ArgSpan& arg_vals, const std::string& arg_delim) override;
+
+    void text(const std::string& arg_text) override;
+};
+
+/**
+ * Comma-separated numbers in the shortest form that reads back to the
+ * same double. Texts are written as lines, so that print("...") can write
+ * a header row.
+ */
+class CsvSink : public OutputSink {
+public:
+
+    explicit CsvSink(std::ostream& arg_os) : OutputSink(arg_os) {
+    }
+
+    std::unique_ptr<OutputSink> clone(std::ostream& arg_os) const override {
+        return std::unique_ptr<OutputSink>(new CsvSink(arg_os));
+    }
+
+    void row(const ASTReader::ArgSpan& arg_vals, const std::string& arg_delim) override;
+
+    void text(const std::string& arg_text) override;
+};
+
+/**
+ * Each row as its number of values, a uint32, followed by the values as
+ * doubles, all little-endian. Texts are not written.
+ */
+class BinarySink : public OutputSink {
+public:
+
+    explicit BinarySink(std::ostream& arg_os) : OutputSink(arg_os) {
+    }
+
+    std::unique_ptr<OutputSink> clone(std::ostream& arg_os) const override {
+        return std::unique_ptr<OutputSink>(new BinarySink(arg_os));
+    }
+
+    void row(const ASTReader::ArgSpan& arg_vals, const std::string& arg_delim) override;
+
+    void text(const std::string&) override {
+    }
+};
+
+#endif /* OUTPUT_SINK_H */
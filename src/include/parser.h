@@ -29,6 +29,62 @@ namespace Parser {
         }
     } md;
 
+    /*
+     * Semantic actions. The binary rules parse their first operand once
+     * and wrap it afterwards, rather than trying alternatives that parse
+     * the same operand again, which took time exponential in the nesting
+     * depth. A single operand is kept unwrapped, as before. no_skip[eps]
+     * starts an expectation without skipping spaces, so that errors are
+     * reported at the same position as before.
+     */
+    template<class Type, class Variant>
+    Type& _get(Variant& arg_variant) {
+        return boost::get<x3::forward_ast<Type>>(arg_variant.get()).get();
+    }
+
+    const auto _assign = [](auto& arg_ctx) {
+        x3::_val(arg_ctx) = std::move(x3::_attr(arg_ctx));
+    };
+
+    const auto _assignList = [](auto& arg_ctx) {
+        auto& list = x3::_attr(arg_ctx);
+        if (list.size() == 1) {
+            x3::_val(arg_ctx) = std::move(list.front());
+        } else {
+            x3::_val(arg_ctx) = std::move(list);
+        }
+    };
+
+    const auto _assignTimes = [](auto& arg_ctx) {
+        AST::_Times& times = x3::_attr(arg_ctx);
+        if (times.rest.empty()) {
+            x3::_val(arg_ctx) = std::move(times.first);
+        } else {
+            x3::_val(arg_ctx) = std::move(times);
+        }
+    };
+
+    const auto _powerInt = [](auto& arg_ctx) {
+        AST::_PowerInt power;
+        power.base = std::move(_get<AST::Signed>(x3::_val(arg_ctx)));
+        power.iexp = x3::_attr(arg_ctx);
+        x3::_val(arg_ctx) = std::move(power);
+    };
+
+    const auto _powerUnary = [](auto& arg_ctx) {
+        AST::_PowerUnary power;
+        power.base = std::move(_get<AST::Signed>(x3::_val(arg_ctx)));
+        power.uexp = std::move(x3::_attr(arg_ctx));
+        x3::_val(arg_ctx) = std::move(power);
+    };
+
+    const auto _relational = [](auto& arg_ctx) {
+        AST::_Relational rel;
+        rel.first = std::move(_get<AST::Plus>(x3::_val(arg_ctx)));
+        rel.rest = std::move(x3::_attr(arg_ctx));
+        x3::_val(arg_ctx) = std::move(rel);
+    };
+
     struct _IdentName_class;
     struct _ConstExpr_class;
     struct _IfExpr_class;
@@ -38,11 +94,15 @@ namespace Parser {
     struct _PowerUExpr_class;
     struct _PowerIExpr_class;
     struct PowerExpr_class;
+    struct _TimesExpr_class;
     struct TimesExpr_class;
+    struct _PlusExpr_class;
     struct PlusExpr_class;
     struct _RelOpExpr_class;
     struct RelExpr_class;
+    struct _AndExpr_class;
     struct AndExpr_class;
+    struct _OrExpr_class;
     struct OrExpr_class;
     struct _RecurExpr_class;
     struct _SubstExpr_class;
@@ -58,11 +118,15 @@ namespace Parser {
     typedef x3::rule<PrimaryExpr_class, AST::Primary> PrimaryExpr_type;
     typedef x3::rule<UnaryExpr_class, AST::Signed> UnaryExpr_type;
     typedef x3::rule<PowerExpr_class, AST::Power> PowerExpr_type;
+    typedef x3::rule<_TimesExpr_class, AST::_Times> _TimesExpr_type;
     typedef x3::rule<TimesExpr_class, AST::Times> TimesExpr_type;
+    typedef x3::rule<_PlusExpr_class, AST::_Plus> _PlusExpr_type;
     typedef x3::rule<PlusExpr_class, AST::Plus> PlusExpr_type;
     typedef x3::rule<_RelOpExpr_class, AST::_RelOp> _RelOpExpr_type;
     typedef x3::rule<RelExpr_class, AST::Relational> RelExpr_type;
+    typedef x3::rule<_AndExpr_class, AST::_AndRel> _AndExpr_type;
     typedef x3::rule<AndExpr_class, AST::AndRel> AndExpr_type;
+    typedef x3::rule<_OrExpr_class, AST::_OrRel> _OrExpr_type;
     typedef x3::rule<OrExpr_class, AST::OrRel> OrExpr_type;
     typedef x3::rule<_SubstExpr_class, AST::_Substitute> _SubstExpr_type;
     typedef x3::rule<SubstExpr_class, AST::Substitute> SubstExpr_type;
@@ -78,11 +142,15 @@ namespace Parser {
     const PrimaryExpr_type PrimaryExpr = "Expression";
     const UnaryExpr_type UnaryExpr = "Expression";
     const PowerExpr_type PowerExpr = "Expression";
+    const _TimesExpr_type _TimesExpr = "Expression";
     const TimesExpr_type TimesExpr = "Expression";
+    const _PlusExpr_type _PlusExpr = "Expression";
     const PlusExpr_type PlusExpr = "Expression";
     const _RelOpExpr_type _RelOpExpr = "Relational Operator";
     const RelExpr_type RelExpr = "Expression";
+    const _AndExpr_type _AndExpr = "Expression";
     const AndExpr_type AndExpr = "Expression";
+    const _OrExpr_type _OrExpr = "Expression";
     const OrExpr_type OrExpr = "Expression";
     const _SubstExpr_type _SubstExpr = "Expression";
     const SubstExpr_type SubstExpr = "Expression";
@@ -98,13 +166,17 @@ namespace Parser {
     const auto _FuncCallExpr_def = (_IdentName - x3::lit("if")) >> '(' >> -(_RecurExpr % ',') > ')';
     const auto PrimaryExpr_def = (_ConstExpr | _IfExpr | _FuncCallExpr | x3::double_ | '(' > _RecurExpr > ')') > !(x3::alnum | x3::char_("(_."));
     const auto UnaryExpr_def = PrimaryExpr | (pm > PrimaryExpr);
-    const auto PowerExpr_def = (UnaryExpr >> !x3::char_('^')) | (UnaryExpr >> '^' >> x3::int_ >> !x3::lit('.')) | (UnaryExpr >> '^' > UnaryExpr);
-    const auto TimesExpr_def = (PowerExpr >> !x3::char_("*/")) | (PowerExpr > +(md > PowerExpr));
-    const auto PlusExpr_def = (TimesExpr >> !TimesExpr) | x3::repeat(2, x3::inf)[TimesExpr];
+    const auto PowerExpr_def = UnaryExpr[_assign] >> -('^' >> ((x3::int_ >> !x3::lit('.'))[_powerInt] | (x3::no_skip[x3::eps] > UnaryExpr)[_powerUnary]));
+    const auto _TimesExpr_def = PowerExpr >> *(md > PowerExpr);
+    const auto TimesExpr_def = _TimesExpr[_assignTimes];
+    const auto _PlusExpr_def = +TimesExpr;
+    const auto PlusExpr_def = _PlusExpr[_assignList];
     const auto _RelOpExpr_def = (x3::string("<=") | x3::string(">=") | x3::string("==") | x3::string("!=") | x3::string("<") | x3::string(">")) > PlusExpr;
-    const auto RelExpr_def = (PlusExpr >> !(x3::char_("<!>") | x3::lit("=="))) | (PlusExpr > _RelOpExpr);
-    const auto AndExpr_def = (RelExpr >> !x3::char_('&')) | (RelExpr % '&');
-    const auto OrExpr_def = (AndExpr >> !x3::char_('|')) | (AndExpr % '|');
+    const auto RelExpr_def = PlusExpr[_assign] >> -(&(x3::char_("<!>") | x3::lit("==")) > _RelOpExpr)[_relational];
+    const auto _AndExpr_def = RelExpr % '&';
+    const auto AndExpr_def = _AndExpr[_assignList];
+    const auto _OrExpr_def = AndExpr % '|';
+    const auto OrExpr_def = _OrExpr[_assignList];
     const auto _SubstExpr_def = +(_IdentName >> '=') > OrExpr;
     const auto SubstExpr_def = _SubstExpr | (OrExpr > !x3::char_('='));
     const auto _RecurExpr_def = SubstExpr;
@@ -113,7 +185,7 @@ namespace Parser {
     const auto Expression_def = (_FuncDefExpr | (SubstExpr > !x3::char_(':'))) >> !x3::char_;
 
     BOOST_SPIRIT_DEFINE(_IdentName, _ConstExpr, _IfExpr, _FuncCallExpr, PrimaryExpr, UnaryExpr, PowerExpr,
-            TimesExpr, PlusExpr, _RelOpExpr, RelExpr, AndExpr, OrExpr, _SubstExpr, SubstExpr,
+            _TimesExpr, TimesExpr, _PlusExpr, PlusExpr, _RelOpExpr, RelExpr, _AndExpr, AndExpr, _OrExpr, OrExpr, _SubstExpr, SubstExpr,
             _RecurExpr, _FuncNameExpr, _FuncDefExpr, Expression)
 
 }
@@ -0,0 +1,123 @@
+/**
+ * @file profiler.h
+ * @brief Wall-time profiler for script lines, builtins and parsing
+ * @date Created on: 2026/10/17, 20:10
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PROFILER_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_RDTSC
+#endif
+
+/**
+ * Accumulates wall time and call counts. Each interpreter, worker or not,
+ * owns its own profiler so that the timers need no locks, and the results
+ * are merged once at the end. Times are read from the TSC where available
+ * and converted to seconds with the rate measured over the whole run.
+ */
+class Profiler {
+public:
+
+    struct Stat {
+        uint64_t ticks = 0;
+        uint64_t count = 0;
+    };
+
+    /**
+     * Adds the time between its construction and destruction to a Stat.
+     * Does nothing for a null Stat, so that the timers can stay in place
+     * when profiling is off.
+     */
+    class Scope {
+        Stat* _stat;
+        uint64_t _start, _count;
+    public:
+
+        Scope(Stat* arg_stat, const uint64_t& arg_count = 1) : _stat(arg_stat), _start(arg_stat ? now() : 0), _count(arg_count) {
+        }
+
+        ~Scope() {
+            if (_stat) {
+                _stat->ticks += now() - _start;
+                _stat->count += _count;
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    static uint64_t now() {
+#ifdef PROFILER_RDTSC
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+protected:
+    std::vector<Stat> _lines, _funcs;
+    Stat _records, _datasets;
+    std::vector<std::pair<char, std::string>> _sources;
+    std::chrono::steady_clock::time_point _startTime;
+    uint64_t _startTicks;
+
+    static Stat& _at(std::vector<Stat>& arg_stats, const size_t& arg_i) {
+        if (arg_stats.size() <= arg_i) {
+            arg_stats.resize(arg_i + 1);
+        }
+        return arg_stats[arg_i];
+    }
+
+public:
+
+    Profiler() : _startTime(std::chrono::steady_clock::now()), _startTicks(now()) {
+    }
+
+    /**
+     * Registers the section and the text of a source line for the report.
+     */
+    void setSource(const size_t& arg_line, const char& arg_section, const std::string& arg_text) {
+        if (_sources.size() <= arg_line) {
+            _sources.resize(arg_line + 1);
+        }
+        _sources[arg_line] = std::make_pair(arg_section, arg_text);
+    }
+
+    Stat* line(const size_t& arg_line) {
+        return &_at(_lines, arg_line);
+    }
+
+    Stat* func(const int32_t& arg_func) {
+        return &_at(_funcs, arg_func);
+    }
+
+    Stat* records() {
+        return &_records;
+    }
+
+    Stat* datasets() {
+        return &_datasets;
+    }
+
+    void merge(const Profiler& arg_other);
+
+    /**
+     * Prints the time, the number of calls and the share of the total wall
+     * time per section, per source line, per builtin and for parsing.
+     */
+    void report(std::ostream& arg_os, const std::vector<std::string>& arg_funcNames) const;
+};
+
+#endif /* PROFILER_H */
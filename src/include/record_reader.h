@@ -0,0 +1,264 @@
+/**
+ * @file record_reader.h
+ * @brief Reader of the numbers in [DATASET] sections
+ * @date Created on: 2026/10/17, 22:30
+ */
+
+#ifndef RECORD_READER_H
+#define RECORD_READER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <istream>
+#include <string>
+#include <vector>
+#include <boost/spirit/home/x3.hpp>
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+/**
+ * Reads lines of numbers separated by a delimiter, such as the records and
+ * the dataset values, directly into a row buffer. The delimiter and the
+ * number of values are fixed on construction, so that nothing is built
+ * per line. The syntax is that of (x3::double_ % delim) >> *space: no
+ * space before a number, and trailing spaces allowed. Numbers are read
+ * with a fast path for short decimals and std::from_chars otherwise,
+ * both rounding correctly, where from_chars is available.
+ */
+class RecordReader {
+    std::string _delim;
+    size_t _nVals;
+
+    static bool _isSpace(const char& arg_c) {
+        return arg_c == ' ' || (arg_c >= '\t' && arg_c <= '\r');
+    }
+
+    static bool _isDigit(const char& arg_c) {
+        return (unsigned char) (arg_c - '0') < 10;
+    }
+
+    /**
+     * Reads a decimal number of at most 19 significant digits whose value
+     * is an integer below 2^53 times a power of ten up to 10^22, which
+     * covers the usual data files. Both factors are exact doubles, so
+     * that a single multiplication or division rounds correctly (Clinger's
+     * fast path). Returns nullptr for anything else.
+     */
+    static const char* _decimal(const char* arg_first, const char* arg_last, double& arg_val) {
+        static const double pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        const char* it = arg_first;
+        bool isNegative = false;
+        if (it != arg_last && (*it == '-' || *it == '+')) {
+            isNegative = *it == '-';
+            it++;
+        }
+        uint64_t mantissa = 0;
+        int nDigits = 0, exp10 = 0;
+        bool hasDigit = false;
+        for (; it != arg_last && _isDigit(*it); it++) {
+            mantissa = mantissa * 10 + (*it - '0');
+            nDigits += mantissa != 0;
+            hasDigit = true;
+        }
+        if (it != arg_last && *it == '.') {
+            for (it++; it != arg_last && _isDigit(*it); it++) {
+                mantissa = mantissa * 10 + (*it - '0');
+                nDigits += mantissa != 0;
+                exp10--;
+                hasDigit = true;
+            }
+        }
+        if (!hasDigit || nDigits > 19) {
+            return nullptr;
+        }
+        if (it != arg_last && (*it == 'e' || *it == 'E')) {
+            const char* exp = it + 1;
+            bool isExpNegative = false;
+            if (exp != arg_last && (*exp == '-' || *exp == '+')) {
+                isExpNegative = *exp == '-';
+                exp++;
+            }
+            // Without digits, the 'e' is not part of the number.
+            if (exp != arg_last && _isDigit(*exp)) {
+                int expVal = 0;
+                for (; exp != arg_last && _isDigit(*exp); exp++) {
+                    expVal = std::min(expVal * 10 + (*exp - '0'), 10000);
+                }
+                exp10 += isExpNegative ? -expVal : expVal;
+                it = exp;
+            }
+        }
+        if (mantissa > (uint64_t(1) << 53) || exp10 < -22 || exp10 > 22) {
+            return nullptr;
+        }
+        double val = double(mantissa);
+        val = exp10 < 0 ? val / pow10[-exp10] : val * pow10[exp10];
+        arg_val = isNegative ? -val : val;
+        return it;
+    }
+
+    /**
+     * Reads one number at arg_first, returning the end of it, or nullptr
+     * if there is none.
+     */
+    static const char* _number(const char* arg_first, const char* arg_last, double& arg_val) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        if (const char* end = _decimal(arg_first, arg_last, arg_val)) {
+            return end;
+        }
+        const char* first = arg_first;
+        // from_chars takes no plus sign, which x3::double_ does.
+        if (first != arg_last && *first == '+') {
+            first++;
+            if (first == arg_last || *first == '-' || *first == '+') {
+                return nullptr;
+            }
+        }
+        std::from_chars_result result = std::from_chars(first, arg_last, arg_val);
+        if (result.ec == std::errc()) {
+            return result.ptr;
+        }
+        if (result.ec == std::errc::result_out_of_range) {
+            // from_chars leaves arg_val unset. Underflow gives +-0 as with
+            // x3::double_, and overflow is an error as with it.
+            const double val = std::strtod(std::string(first, result.ptr).c_str(), nullptr);
+            if (std::isinf(val)) {
+                return nullptr;
+            }
+            arg_val = val;
+            return result.ptr;
+        }
+        return nullptr;
+#else
+        namespace x3 = boost::spirit::x3;
+        return x3::parse(arg_first, arg_last, x3::double_, arg_val) ? arg_first : nullptr;
+#endif
+    }
+
+public:
+    static const size_t npos = size_t(-1);
+
+    RecordReader(const std::string& arg_delim, const size_t& arg_nVals) : _delim(arg_delim), _nVals(arg_nVals) {
+    }
+
+    const size_t& size() const {
+        return _nVals;
+    }
+
+    /**
+     * Reads [arg_first, arg_last) into arg_vals, which holds size() values.
+     * Returns the number of values on the line, which may differ from
+     * size(), or npos if the line is not a list of numbers.
+     */
+    size_t read(const char* arg_first, const char* arg_last, double* arg_vals) const {
+        const char* it = arg_first;
+        size_t n = 0;
+        double val;
+        while (true) {
+            const char* end = _number(it, arg_last, val);
+            if (!end) {
+                if (n == 0) {
+                    return npos;
+                }
+                // Not a number after the delimiter: it belongs to the
+                // trailing spaces, if anything.
+                it -= _delim.size();
+                break;
+            }
+            if (n < _nVals) {
+                arg_vals[n] = val;
+            }
+            n++;
+            it = end;
+            if (size_t(arg_last - it) >= _delim.size() && std::memcmp(it, _delim.data(), _delim.size()) == 0) {
+                it += _delim.size();
+            } else {
+                break;
+            }
+        }
+        while (it != arg_last && _isSpace(*it)) {
+            it++;
+        }
+        return it == arg_last ? n : npos;
+    }
+
+    size_t read(const std::string& arg_line, double* arg_vals) const {
+        return read(arg_line.data(), arg_line.data() + arg_line.size(), arg_vals);
+    }
+};
+
+/**
+ * Splits a stream into lines like std::getline, but reads the stream
+ * buffer in blocks and returns each line in place. Only reads what the
+ * stream buffer has available, so that an interactive input is processed
+ * line by line.
+ */
+class LineReader {
+    std::streambuf* _sbuf;
+    std::vector<char> _buf;
+    size_t _begin, _end;
+    // Stream positions of the start of _buf and of the last line, or -1 if
+    // the stream cannot tell.
+    std::streamoff _base, _offset;
+
+public:
+
+    explicit LineReader(std::istream& arg_is, const size_t& arg_bufSize = 1 << 16) : _sbuf(arg_is.rdbuf()), _buf(arg_bufSize), _begin(0), _end(0),
+    _base(_sbuf ? std::streamoff(_sbuf->pubseekoff(0, std::ios::cur, std::ios::in)) : std::streamoff(-1)), _offset(-1) {
+    }
+
+    /**
+     * Stream position of the line last returned by next, or -1 if the
+     * stream cannot seek.
+     */
+    std::streamoff offset() const {
+        return _offset;
+    }
+
+    /**
+     * Sets [arg_first, arg_last) to the next line without its '\n', valid
+     * until the next call. Returns false at the end of the stream.
+     */
+    bool next(const char*& arg_first, const char*& arg_last) {
+        size_t searched = _begin;
+        while (true) {
+            if (const void* newline = std::memchr(_buf.data() + searched, '\n', _end - searched)) {
+                arg_first = _buf.data() + _begin;
+                arg_last = static_cast<const char*> (newline);
+                _offset = _base < 0 ? -1 : _base + std::streamoff(_begin);
+                _begin = arg_last - _buf.data() + 1;
+                return true;
+            }
+            const size_t size = _end - _begin;
+            if (_begin != 0) {
+                _base = _base < 0 ? -1 : _base + std::streamoff(_begin);
+                std::memmove(_buf.data(), _buf.data() + _begin, size);
+                _begin = 0;
+                _end = size;
+            }
+            if (_end == _buf.size()) {
+                _buf.resize(2 * _buf.size());
+            }
+            searched = _end;
+            if (!_sbuf || std::streambuf::traits_type::eq_int_type(_sbuf->sgetc(), std::streambuf::traits_type::eof())) {
+                if (_begin == _end) {
+                    return false;
+                }
+                arg_first = _buf.data() + _begin;
+                arg_last = _buf.data() + _end;
+                _offset = _base < 0 ? -1 : _base + std::streamoff(_begin);
+                _begin = _end;
+                return true;
+            }
+            std::streamsize avail = std::max<std::streamsize>(_sbuf->in_avail(), 1);
+            _end += _sbuf->sgetn(_buf.data() + _end, std::min<std::streamsize>(avail, _buf.size() - _end));
+        }
+    }
+};
+
+#endif /* RECORD_READER_H */
@@ -0,0 +1,143 @@
+/**
+ * @file rg_data.h
+ * @brief Binary columnar container of RG data
+ * @date Created on: 2026/10/17, 17:05
+ */
+
+#ifndef RG_DATA_H
+#define RG_DATA_H
+
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Layout of the container. All numbers are little-endian and every
+ * section starts at a multiple of 8 bytes.
+ *
+ *   header (40 bytes):
+ *     char[8]   magic "ELVASRGD"
+ *     uint32    format version
+ *     uint32    number of DATASET_VARS
+ *     uint32    number of RECORD_VARS
+ *     uint32    reserved
+ *     uint64    number of datasets
+ *     uint64    offset of the trailer
+ *   data:
+ *     for each dataset, RECORD_VARS columns of nRecords doubles
+ *   trailer:
+ *     names of DATASET_VARS then RECORD_VARS as (uint32 length, chars),
+ *     padded to 8 bytes, followed by one entry per dataset:
+ *     uint64 offset of the columns, uint64 nRecords,
+ *     uint64 number of dataset values, double[DATASET_VARS] values
+ *
+ * RGData is a read-only view of a memory-mapped container.
+ */
+class RGData {
+public:
+    static const char magic[8];
+    static const uint32_t version = 1;
+    static const size_t headerSize = 40;
+
+    class RGDataError : public std::runtime_error {
+    public:
+
+        RGDataError(const std::string& str) : std::runtime_error(str) {
+        }
+    };
+
+    static bool isLittleEndian() {
+        const uint16_t test = 1;
+        return *reinterpret_cast<const char*> (&test) == 1;
+    }
+
+protected:
+    const char* _base;
+    size_t _size;
+    std::vector<double> _buffer;
+    std::vector<std::string> _datasetVarNames, _recordVarNames;
+    const char* _table;
+    size_t _nDatasets;
+
+    void _parse(const std::string& arg_path);
+
+    const uint64_t* _entry(const size_t& arg_dataset) const {
+        return reinterpret_cast<const uint64_t*> (_table + arg_dataset * (24 + 8 * _datasetVarNames.size()));
+    }
+
+public:
+
+    RGData(const std::string& arg_path);
+
+    RGData(const RGData&) = delete;
+
+    RGData& operator=(const RGData&) = delete;
+
+    ~RGData();
+
+    static bool isRGData(const std::string& arg_path);
+
+    const std::vector<std::string>& datasetVarNames() const {
+        return _datasetVarNames;
+    }
+
+    const std::vector<std::string>& recordVarNames() const {
+        return _recordVarNames;
+    }
+
+    size_t size() const {
+        return _nDatasets;
+    }
+
+    size_t nRecords(const size_t& arg_dataset) const {
+        return _entry(arg_dataset)[1];
+    }
+
+    size_t nDatasetVals(const size_t& arg_dataset) const {
+        return _entry(arg_dataset)[2];
+    }
+
+    const double* datasetVals(const size_t& arg_dataset) const {
+        return reinterpret_cast<const double*> (_entry(arg_dataset) + 3);
+    }
+
+    const double* column(const size_t& arg_dataset, const size_t& arg_var) const {
+        return reinterpret_cast<const double*> (_base + _entry(arg_dataset)[0]) + arg_var * nRecords(arg_dataset);
+    }
+};
+
+/**
+ * Writes datasets given row by row as a container.
+ */
+class RGDataWriter {
+protected:
+    std::ofstream _ofs;
+    std::vector<std::vector<double>> _datasetVals;
+    std::vector<uint64_t> _offsets, _nRecords;
+    std::vector<double> _rows;
+    size_t _nRecordVars;
+    bool _isOpen;
+
+    template<class Number>
+    void _write(const Number& arg_val) {
+        _ofs.write(reinterpret_cast<const char*> (&arg_val), sizeof (Number));
+    }
+
+    void _pad();
+
+public:
+
+    RGDataWriter(const std::string& arg_path);
+
+    void beginDataset(const std::vector<double>& arg_datasetVals);
+
+    void addRecord(const std::vector<double>& arg_recordVals);
+
+    void endDataset();
+
+    void close(const std::vector<std::string>& arg_datasetVarNames, const std::vector<std::string>& arg_recordVarNames);
+};
+
+#endif /* RG_DATA_H */
@@ -0,0 +1,66 @@
+/**
+ * @file rge_solver.h
+ * @brief Adaptive integrator of renormalization group equations
+ * @date Created on: 2026/10/17, 23:40
+ */
+
+#ifndef RGE_SOLVER_H
+#define RGE_SOLVER_H
+
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * Integrates dy/dt = beta(y), with t = ln Q, by the Dormand-Prince 5(4)
+ * method with adaptive steps. The step is kept between calls of evolve,
+ * so that a run sampled at many scales takes about as many steps as a
+ * single call over the whole range.
+ */
+class RGESolver {
+public:
+    typedef std::function<void(const double* arg_y, double* arg_dy)> Beta;
+
+    static const size_t maxSteps = 100000;
+
+    class RGESolverError : public std::runtime_error {
+    public:
+
+        RGESolverError(const std::string& str) : std::runtime_error(str) {
+        }
+    };
+
+protected:
+    size_t _nVars;
+    Beta _beta;
+    double _tolerance;
+    double _step;
+    size_t _nSteps;
+    std::vector<double> _k[7], _yTemp, _yNew;
+    bool _hasSlope;
+
+public:
+
+    /**
+     * arg_tolerance bounds the local error of each variable relative to
+     * one plus its size.
+     */
+    RGESolver(const size_t& arg_nVars, const Beta& arg_beta, const double& arg_tolerance = 1e-10);
+
+    /**
+     * Evolves arg_y from arg_t to arg_tEnd and sets arg_t to arg_tEnd.
+     * Returns false if the solution diverges or is not finite on the way,
+     * as at a Landau pole, leaving arg_t and arg_y at the last point
+     * reached.
+     */
+    bool evolve(double& arg_t, double* arg_y, const double& arg_tEnd);
+
+    /**
+     * Number of accepted steps so far.
+     */
+    size_t steps() const {
+        return _nSteps;
+    }
+};
+
+#endif /* RGE_SOLVER_H */
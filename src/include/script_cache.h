@@ -0,0 +1,110 @@
+/**
+ * @file script_cache.h
+ * @brief On-disk cache of compiled scripts
+ * @date Created on: 2026/10/17, 21:50
+ */
+
+#ifndef SCRIPT_CACHE_H
+#define SCRIPT_CACHE_H
+
+#include "compiler.h"
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * The script part of an input, i.e. everything before the first [DATASET]
+ * section, as a list of actions that replay its effect on the interpreter
+ * without parsing. Programs are stored after identifier resolution, so
+ * the symbol tables are stored as well and restored first.
+ *
+ * Action types:
+ *   'H' section header, 'G' string and 'L' list of [GENERAL],
+ *   'I' program run in [INITIALIZE], 'T' text printed in [INITIALIZE],
+ *   'P' text of a print("...") routine, 'R' routine program.
+ *
+ * The file starts with the magic "ELVASCSC", a format version and a
+ * checksum of the rest, and all numbers are little-endian. Files are named after key(), which hashes
+ * the script text together with everything that affects its compilation.
+ * The text itself is stored as well, since the hash may collide.
+ */
+class ScriptCache {
+public:
+    static const char magic[8];
+    static const uint32_t version = 2;
+
+    class ScriptCacheError : public std::runtime_error {
+    public:
+
+        ScriptCacheError(const std::string& str) : std::runtime_error(str) {
+        }
+    };
+
+    struct Action {
+        char type;
+        char section;
+        int32_t line;
+        std::string name, text;
+        std::vector<std::string> list;
+        ASTReader::Program prog;
+    };
+
+    std::vector<std::string> vars, funcs;
+    std::vector<Action> actions;
+
+protected:
+
+    template<class DataType>
+    static void _write(std::ostream& arg_os, const DataType& arg_val) {
+        arg_os.write(reinterpret_cast<const char*> (&arg_val), sizeof (DataType));
+    }
+
+    static void _write(std::ostream& arg_os, const std::string& arg_str);
+
+    static void _write(std::ostream& arg_os, const std::vector<std::string>& arg_strs);
+
+    static void _write(std::ostream& arg_os, const ASTReader::Program& arg_prog);
+
+    template<class DataType>
+    static void _read(std::istream& arg_is, DataType& arg_val) {
+        arg_is.read(reinterpret_cast<char*> (&arg_val), sizeof (DataType));
+    }
+
+    static void _read(std::istream& arg_is, std::string& arg_str);
+
+    static void _read(std::istream& arg_is, std::vector<std::string>& arg_strs);
+
+    static void _read(std::istream& arg_is, ASTReader::Program& arg_prog, const int& arg_depth = 0);
+
+    /**
+     * Whether every operand of arg_prog and of the functions it defines is
+     * within its registers, the arg_nVars variables, the arg_nFuncs
+     * functions or its own tables, so that it can be run as it is.
+     */
+    static bool _isValid(const ASTReader::Program& arg_prog, const size_t& arg_nVars, const size_t& arg_nFuncs);
+
+public:
+
+    /**
+     * File name for arg_text: 16 hex digits of its 64-bit FNV-1a hash.
+     */
+    static std::string key(const std::string& arg_text);
+
+    /**
+     * Returns false if the file does not exist, is of another version or
+     * was made from another text than arg_text. Throws ScriptCacheError if
+     * it is corrupt.
+     */
+    bool read(const std::string& arg_path, const std::string& arg_text);
+
+    /**
+     * Writes the cache of arg_text to a temporary file and renames it, so
+     * that concurrent runs never read a partial file. Failures are
+     * ignored, as the cache is only an optimization.
+     */
+    void write(const std::string& arg_path, const std::string& arg_text) const;
+};
+
+#endif /* SCRIPT_CACHE_H */
@@ -0,0 +1,60 @@
+/**
+ * @file thread_pool.h
+ * @brief Fixed-size pool of worker threads
+ * @date Created on: 2026/10/17, 16:40
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * Runs submitted jobs on a fixed number of threads in FIFO order.
+ * Each job receives the index of the thread running it, so that callers
+ * can keep per-thread state in a plain vector.
+ */
+class ThreadPool {
+protected:
+    std::vector<std::thread> _threads;
+    std::queue<std::function<void(size_t)>> _jobs;
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    bool _stop;
+
+    void _run(size_t arg_id);
+
+public:
+
+    ThreadPool(size_t arg_size);
+
+    ~ThreadPool();
+
+    size_t size() const {
+        return _threads.size();
+    }
+
+    template<class Func>
+    auto submit(Func&& arg_func) -> std::future<decltype(arg_func(size_t()))> {
+        using Result = decltype(arg_func(size_t()));
+        auto job = std::make_shared<std::packaged_task<Result(size_t)>>(std::forward<Func>(arg_func));
+        std::future<Result> result = job->get_future();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _jobs.emplace([job](size_t arg_id) {
+                (*job)(arg_id);
+            });
+        }
+        _cond.notify_one();
+        return result;
+    }
+};
+
+#endif /* THREAD_POOL_H */
@@ -5,10 +5,19 @@
  */
 
 #include "include/interpreter.h"
+#include "include/version.h"
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
 
-void Interpreter::_executeAST(std::vector<AST::Expression>& arg_asts) {
-    for (auto& ast : arg_asts) {
-        _eval(ast);
+void Interpreter::_executeAST(std::vector<ASTReader::Program>& arg_progs) {
+    for (auto& prog : arg_progs) {
+        {
+            Profiler::Scope scope(_profiler ? _profiler->line(prog.line) : nullptr);
+            _eval.execute(prog);
+        }
         if (_continue) {
             _continue = false;
             break;
@@ -20,22 +29,495 @@ void Interpreter::_executeAST(std::vector<AST::Expression>& arg_asts) {
     }
 }
 
-void Interpreter::_beginFunc(const std::vector<std::string>& arg_varNames, const std::vector<double>& arg_secVals) {
+void Interpreter::_optimize() {
+    std::vector<ASTReader::Program>* routines[] = {&_begRoutine, &_mainRoutine, &_endRoutine, &_finRoutine};
+    const char* names[] = {"[BEGIN_ROUTINE]", "[MAIN_ROUTINE]", "[END_ROUTINE]", "[FINALIZE]"};
+    if (std::equal(routines, routines + 4, _nOptimized, [](const std::vector<ASTReader::Program>* arg_progs, const size_t & arg_n) {
+            return arg_progs->size() == arg_n;
+        })) {
+        return;
+    }
+    std::vector<char> isDefined;
+    _findDefinitions(isDefined);
+    for (int i = 0; i < 4; i++) {
+        if (_nOptimized[i] == routines[i]->size()) {
+            continue;
+        }
+        ASTReader::Optimizer::Report report = ASTReader::Optimizer::optimize(_eval, *routines[i], _nOptimized[i], isDefined);
+        _nOptimized[i] = routines[i]->size();
+        _explanation.emplace_back(std::string(names[i]) + " folded: " + std::to_string(report.nFolded) + ", shared: " + std::to_string(report.nShared)
+                + ", instructions removed: " + std::to_string(report.nRemoved));
+        for (const auto& note : report.notes) {
+            _explanation.emplace_back("  " + std::to_string(note.first) + ": " + note.second);
+        }
+    }
+    _snapshot.reset();
+}
+
+void Interpreter::_findDefinitions(std::vector<char>& arg_isDefined) const {
+    arg_isDefined = _initDefined;
+    for (const auto& progs : {&_begRoutine, &_mainRoutine, &_endRoutine, &_finRoutine}) {
+        ASTReader::Optimizer::findDefinitions(*progs, arg_isDefined);
+    }
+}
+
+std::vector<int32_t> Interpreter::_recordSlots() {
+    std::vector<int32_t> recordSlots;
+    auto addSlots = [this, &recordSlots](const std::vector<std::string>& arg_names, const std::string& arg_key) {
+        auto it_names = _lists.find(arg_key);
+        for (const auto& name : !arg_names.empty() || it_names == _lists.end() ? arg_names : it_names->second) {
+            recordSlots.emplace_back(_eval.getSlot(name));
+        }
+    };
+    addSlots(_recordVarNames, "RECORD_VARS");
+    addSlots(_rgVarNames, "RG_VARS");
+    auto it_scale = _strings.find("RG_SCALE");
+    if (!_rgScale.empty() || it_scale != _strings.end()) {
+        recordSlots.emplace_back(_eval.getSlot(!_rgScale.empty() ? _rgScale : it_scale->second));
+    }
+    return recordSlots;
+}
+
+void Interpreter::_hoist(const std::vector<int32_t>& arg_datasetSlots) {
+    std::vector<char> isDefined;
+    _findDefinitions(isDefined);
+    _perRecord = _mainRoutine;
+    ASTReader::Optimizer::Report report = ASTReader::Optimizer::hoist(_eval, _perRecord, _perDataset, {&_begRoutine, &_endRoutine}, arg_datasetSlots, _recordSlots(), isDefined);
+    _nHoisted = _mainRoutine.size();
+    _hoistExplanation = {"[MAIN_ROUTINE] hoisted: " + std::to_string(report.nHoisted)};
+    for (const auto& note : report.notes) {
+        _hoistExplanation.emplace_back("  " + std::to_string(note.first) + ": " + note.second);
+    }
+}
+
+void Interpreter::_useModel(const std::string& arg_key) {
+    // The model is made from and checked against the optimized routines.
+    _optimize();
+    const ASTReader::NativeModel::Routines routines = {{'B', &_begRoutine}, {'M', &_mainRoutine}, {'E', &_endRoutine}};
+    if (_modelMode == 'C') {
+        ASTReader::NativeModel::build(ASTReader::NativeModel::generate(_eval, routines, arg_key), _modelPath);
+        return;
+    }
+    try {
+        ASTReader::NativeModel model(_modelPath);
+        model.bind(_eval, routines, arg_key);
+        _explanation.emplace_back("Native model " + _modelPath + ": " + std::to_string(model.size()) + " lines");
+    } catch (const ASTReader::NativeModel::NativeModelError& arg_e) {
+        std::cerr << "Warning: " << arg_e.what() << " The script is interpreted." << std::endl;
+    }
+}
+
+void Interpreter::_beginFunc(const std::vector<int32_t>& arg_varSlots, const std::vector<double>& arg_secVals) {
+    if (_writer) {
+        _writer->beginDataset(arg_secVals);
+        return;
+    }
+    _optimize();
+    _isParallel = _runsParallel(arg_varSlots);
+    if (_isParallel) {
+        _task.datasetVarSlots = arg_varSlots;
+        _task.datasetVals = arg_secVals;
+        _task.recordVarSlots.clear();
+        _task.recordVals.clear();
+        return;
+    }
+    // The datasets run by the workers so far come first.
+    _drain();
     int i = 0;
     for (const auto& elem : arg_secVals) {
-        setConst(arg_varNames.at(i), elem);
+        _eval.setSlot(arg_varSlots.at(i), elem);
         i++;
     }
+    _columnMode = _columnar ? 'U' : 'R';
+    _task.recordVals.clear();
+    _rgRun.nPoints = 0;
     _executeAST(_begRoutine);
+    if (_nHoisted != _mainRoutine.size()) {
+        _hoist(arg_varSlots);
+    }
+    for (auto& prog : _perDataset) {
+        Profiler::Scope scope(_profiler ? _profiler->line(prog.line) : nullptr);
+        _eval.execute(prog);
+    }
 }
 
-void Interpreter::_mainFunc(const std::vector<std::string>& arg_varNames, const std::vector<double>& arg_recordVals) {
+void Interpreter::_mainFunc(const std::vector<int32_t>& arg_varSlots, const std::vector<double>& arg_recordVals) {
+    if (_writer) {
+        _writer->addRecord(arg_recordVals);
+        return;
+    }
+    if (_isParallel) {
+        _task.recordVarSlots = arg_varSlots;
+        _task.recordVals.insert(_task.recordVals.end(), arg_recordVals.begin(), arg_recordVals.end());
+        return;
+    }
+    if (_columnMode == 'U') {
+        _columnMode = _columnEval.prepare(_perRecord, arg_varSlots) ? 'C' : 'R';
+    }
+    if (_columnMode == 'C') {
+        _task.recordVarSlots = arg_varSlots;
+        _task.recordVals.insert(_task.recordVals.end(), arg_recordVals.begin(), arg_recordVals.end());
+        return;
+    }
     int i = 0;
     for (const auto& elem : arg_recordVals) {
-        setConst(arg_varNames.at(i), elem);
+        _eval.setSlot(arg_varSlots[i], elem);
         i++;
     }
-    _executeAST(_mainRoutine);
+    _executeAST(_perRecord);
+}
+
+void Interpreter::_mainColumns(const std::vector<int32_t>& arg_varSlots, const std::vector<const double*>& arg_columns, const size_t& arg_nRecords) {
+    if (_columnMode == 'U') {
+        _columnMode = _columnEval.prepare(_perRecord, arg_varSlots) ? 'C' : 'R';
+    }
+    if (_columnMode == 'C') {
+        if (arg_nRecords > 0) {
+            _columnEval.execute(arg_columns, arg_nRecords);
+        }
+        return;
+    }
+    std::vector<double> recordVals(arg_columns.size());
+    for (size_t rec = 0; rec < arg_nRecords && _section == 'D'; rec++) {
+        for (size_t var = 0; var < arg_columns.size(); var++) {
+            recordVals[var] = arg_columns[var][rec];
+        }
+        _mainFunc(arg_varSlots, recordVals);
+    }
+}
+
+void Interpreter::_endFunc() {
+    if (_writer) {
+        _writer->endDataset();
+        return;
+    }
+    if (_isParallel) {
+        _dispatch();
+        return;
+    }
+    if (_rgRun.nPoints != 0) {
+        _runRGE();
+    }
+    if (_columnMode == 'C' && !_task.recordVals.empty()) {
+        size_t nVars = _task.recordVarSlots.size();
+        size_t nRecords = _task.recordVals.size() / nVars;
+        std::vector<double> columns(_task.recordVals.size());
+        std::vector<const double*> columnPtrs;
+        for (size_t var = 0; var < nVars; var++) {
+            for (size_t rec = 0; rec < nRecords; rec++) {
+                columns[var * nRecords + rec] = _task.recordVals[rec * nVars + var];
+            }
+            columnPtrs.emplace_back(columns.data() + var * nRecords);
+        }
+        _task.recordVals.clear();
+        _columnEval.execute(columnPtrs, nRecords);
+    }
+    _executeAST(_endRoutine);
+    _output->flush();
+}
+
+void Interpreter::_runRGE() {
+    const _RGRun run = _rgRun;
+    _rgRun.nPoints = 0;
+    _getData(_lists, "RG_VARS", _rgVarNames);
+    _getData(_lists, "RG_BETAS", _rgBetaNames);
+    _getData(_strings, "RG_SCALE", _rgScale);
+    if (_rgBetaNames.size() != _rgVarNames.size()) {
+        throw InterpreterError("RG_BETAS must have one function for each of RG_VARS.");
+    }
+    if (!(run.scaleBeg > 0. && run.scaleEnd > 0.)) {
+        throw InterpreterError("rge: The scales must be positive.");
+    }
+    const size_t nVars = _rgVarNames.size();
+    std::vector<int32_t> slots{_eval.getSlot(_rgScale)}, betas;
+    std::vector<double> record(nVars + 1);
+    for (size_t i = 0; i < nVars; i++) {
+        slots.emplace_back(_eval.getSlot(_rgVarNames[i]));
+        betas.emplace_back(_eval.funcs().intern(_rgBetaNames[i]));
+        try {
+            record[i + 1] = _eval.getConst(_rgVarNames[i]);
+        } catch (const std::out_of_range&) {
+            throw InterpreterError("rge: " + _rgVarNames[i] + " is not set.");
+        }
+    }
+    auto beta = [ this, &betas, nVars ](const double* arg_y, double* arg_dy) {
+        for (size_t i = 0; i < nVars; i++) {
+            arg_dy[i] = _eval.call(betas[i], arg_y, nVars);
+        }
+    };
+    RGESolver solver(nVars, beta, run.tolerance);
+    const double lnScaleBeg = log(run.scaleBeg), lnScaleEnd = log(run.scaleEnd);
+    double lnScale = lnScaleBeg;
+    for (size_t i = 0; i < run.nPoints && _section == 'D'; i++) {
+        const double lnScaleNext = i + 1 == run.nPoints && i != 0 ? lnScaleEnd : lnScaleBeg + (lnScaleEnd - lnScaleBeg) * i / std::max<size_t>(run.nPoints - 1, 1);
+        // The records stop where the couplings diverge.
+        if (!solver.evolve(lnScale, record.data() + 1, lnScaleNext)) {
+            break;
+        }
+        record[0] = i == 0 ? run.scaleBeg : i + 1 == run.nPoints ? run.scaleEnd : exp(lnScale);
+        _mainFunc(slots, record);
+    }
+}
+
+void Interpreter::_getSlots(const std::vector<std::string>& arg_names, std::vector<int32_t>& arg_slots) {
+    if (arg_slots.size() != arg_names.size()) {
+        arg_slots.clear();
+        for (const auto& name : arg_names) {
+            arg_slots.emplace_back(_eval.getSlot(name));
+        }
+        _snapshot.reset();
+    }
+}
+
+void Interpreter::_adopt(const Interpreter& arg_master) {
+    _eval.adopt(arg_master._eval);
+    _begRoutine = arg_master._begRoutine;
+    _mainRoutine = arg_master._mainRoutine;
+    _endRoutine = arg_master._endRoutine;
+    _finRoutine = arg_master._finRoutine;
+    _recordDelim = arg_master._recordDelim;
+    _datasetDelim = arg_master._datasetDelim;
+    _outputDelim = arg_master._outputDelim;
+    _recordVarNames = arg_master._recordVarNames;
+    _datasetVarNames = arg_master._datasetVarNames;
+    _recordVarSlots = arg_master._recordVarSlots;
+    _datasetVarSlots = arg_master._datasetVarSlots;
+    _strings = arg_master._strings;
+    _lists = arg_master._lists;
+    _printStr = arg_master._printStr;
+    _columnar = arg_master._columnar;
+    _rgVarNames = arg_master._rgVarNames;
+    _rgBetaNames = arg_master._rgBetaNames;
+    _rgScale = arg_master._rgScale;
+    std::copy(arg_master._nOptimized, arg_master._nOptimized + 4, _nOptimized);
+    _nHoisted = 0;
+    _os.copyfmt(arg_master._os);
+    _output = arg_master._output->clone(_os);
+}
+
+bool Interpreter::_runsParallel(const std::vector<int32_t>& arg_datasetSlots) {
+    if (!_pool) {
+        return false;
+    }
+    if (!_snapshot) {
+        auto snapshot = std::make_shared<_Worker>();
+        std::vector<char> isDefined;
+        _findDefinitions(isDefined);
+        if (!ASTReader::Optimizer::carriesState(_eval, _begRoutine, _mainRoutine, _endRoutine, arg_datasetSlots, _recordSlots(), isDefined, snapshot->assigned)) {
+            snapshot->interp = _clone(snapshot->os);
+            snapshot->interp->_adopt(*this);
+        }
+        _snapshot = snapshot;
+    }
+    return bool(_snapshot->interp);
+}
+
+void Interpreter::_dispatch() {
+    // The snapshot is made again if the records read since have changed
+    // the state, as the slots of RECORD_VARS do.
+    _runsParallel(_task.datasetVarSlots);
+    auto task = std::make_shared<_DatasetTask>(std::move(_task));
+    _task = _DatasetTask();
+    std::shared_ptr<const _Worker> snapshot = _snapshot;
+    _pending.emplace_back(_pool->submit([this, task, snapshot](size_t arg_id) {
+        _Worker& worker = *_workers.at(arg_id);
+        if (_stopped) {
+            return _DatasetResult{std::string(), nullptr, {}, 0, -1, std::string()};
+        }
+        if (worker.adopted != snapshot) {
+            worker.interp->_adopt(*snapshot->interp);
+            worker.adopted = snapshot;
+        }
+        return worker.interp->_runDataset(*task, *snapshot);
+    }));
+    while (_pending.size() > 4 * _pool->size()) {
+        _emit(true);
+    }
+    _emit(false);
+}
+
+void Interpreter::_emit(bool arg_wait) {
+    while (!_pending.empty()) {
+        if (!arg_wait && _pending.front().wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return;
+        }
+        _DatasetResult result = _pending.front().get();
+        _pending.pop_front();
+        _os << result.output;
+        _output->flush();
+        if (result.error) {
+            _stopped = true;
+            std::rethrow_exception(result.error);
+        }
+        if (result.breakLine > 0) {
+            _stopped = true;
+            _pending.clear();
+            _os << "Wrong syntax in line " << result.breakLine << ":" << std::endl;
+            if (result.breakOffset >= 0) {
+                // The record is read again rather than kept for each task.
+                _is.clear();
+                _is.rdbuf()->pubseekpos(result.breakOffset, std::ios::in);
+                std::getline(_is, result.breakText);
+            }
+            InterpreterError error(result.breakText);
+            error.errorMsg(_os);
+            error.setReported();
+            throw error;
+        }
+        // The state is left as if the datasets had been run in order.
+        for (const auto& elem : result.assigned) {
+            _eval.setSlot(elem.first, elem.second);
+        }
+        if (arg_wait) {
+            return;
+        }
+    }
+}
+
+void Interpreter::_drain() {
+    while (!_pending.empty()) {
+        _emit(true);
+    }
+}
+
+Interpreter::_DatasetResult Interpreter::_runDataset(const _DatasetTask& arg_task, const _Worker& arg_snapshot) {
+    _DatasetResult result{std::string(), nullptr, {}, 0, -1, std::string()};
+    std::ostringstream& os = static_cast<std::ostringstream&> (_os);
+    os.str("");
+    // Each dataset starts from the snapshot, with the variables it may
+    // assign unset, so that those it does assign are told by being set.
+    _eval.restore(arg_snapshot.interp->_eval, arg_snapshot.assigned);
+    try {
+        _beginFunc(arg_task.datasetVarSlots, arg_task.datasetVals);
+        _section = 'D';
+        size_t nVars = arg_task.recordVarSlots.size();
+        std::vector<double> recordVals(nVars);
+        size_t pos = 0;
+        for (; pos < arg_task.recordVals.size() && _section == 'D'; pos += nVars) {
+            std::copy(arg_task.recordVals.begin() + pos, arg_task.recordVals.begin() + pos + nVars, recordVals.begin());
+            _mainFunc(arg_task.recordVarSlots, recordVals);
+        }
+        if (_section == 'D') {
+            _endFunc();
+        } else if (nVars > 0 && pos < arg_task.recordVals.size() && pos / nVars < arg_task.recordLines.size()) {
+            // Read serially, the record would be an error in no section.
+            const size_t rec = pos / nVars;
+            result.breakLine = arg_task.recordLines[rec];
+            result.breakOffset = arg_task.recordOffsets[rec];
+            if (result.breakOffset < 0) {
+                const size_t begin = rec > 0 ? arg_task.recordEnds[rec - 1] : 0;
+                result.breakText = arg_task.recordText.substr(begin, arg_task.recordEnds[rec] - begin);
+            }
+        }
+        _eval.collect(arg_snapshot.assigned, result.assigned);
+    } catch (...) {
+        result.error = std::current_exception();
+    }
+    result.output = os.str();
+    return result;
+}
+
+bool Interpreter::_addRoutine(ASTReader::Program&& arg_prog) {
+    switch (_section) {
+        case 'B':
+            _unoptimized[0].emplace_back(arg_prog);
+            _begRoutine.emplace_back(std::move(arg_prog));
+            return true;
+        case 'M':
+            _unoptimized[1].emplace_back(arg_prog);
+            _mainRoutine.emplace_back(std::move(arg_prog));
+            return true;
+        case 'E':
+            _unoptimized[2].emplace_back(arg_prog);
+            _endRoutine.emplace_back(std::move(arg_prog));
+            return true;
+        case 'F':
+            _unoptimized[3].emplace_back(arg_prog);
+            _finRoutine.emplace_back(std::move(arg_prog));
+            return true;
+    }
+    return false;
+}
+
+void Interpreter::_runInit(const ASTReader::Program& arg_prog, const std::string& arg_text) {
+    if (_profiler) {
+        _profiler->setSource(arg_prog.line, _section, arg_text);
+    }
+    if (!arg_prog.defs.empty()) {
+        ASTReader::Optimizer::findDefinitions({arg_prog}, _initDefined);
+        // Builtins replaced now may have been folded or shared in the
+        // lines optimized so far, which are therefore made again.
+        std::vector<ASTReader::Program>* routines[] = {&_begRoutine, &_mainRoutine, &_endRoutine, &_finRoutine};
+        for (int i = 0; i < 4; i++) {
+            if (_nOptimized[i] > 0) {
+                std::copy(_unoptimized[i].begin(), _unoptimized[i].begin() + _nOptimized[i], routines[i]->begin());
+                _nOptimized[i] = 0;
+                _nHoisted = 0;
+            }
+        }
+    }
+    {
+        Profiler::Scope scope(_profiler ? _profiler->line(arg_prog.line) : nullptr);
+        _eval.execute(arg_prog);
+    }
+    _snapshot.reset();
+    if (_continue || _break) {
+        _continue = false;
+        _break = false;
+        _section = 'N';
+    }
+}
+
+void Interpreter::_record(const char& arg_type, const std::string& arg_name, const std::string& arg_text, const std::vector<std::string>& arg_list, const ASTReader::Program& arg_prog) {
+    if (_recording) {
+        _recording->actions.push_back(ScriptCache::Action{arg_type, _section, _lineNum, arg_name, arg_text, arg_list, arg_prog});
+    }
+}
+
+void Interpreter::_replay(const ScriptCache& arg_cache) {
+    // The programs hold the slots the names had when recorded, so interning
+    // them must give the same slots; checked before anything is run.
+    ASTReader::SymbolTable vars = _eval.vars(), funcs = _eval.funcs();
+    for (const auto& table : {std::make_pair(&vars, &arg_cache.vars), std::make_pair(&funcs, &arg_cache.funcs)}) {
+        for (size_t i = 0; i < table.second->size(); i++) {
+            if (table.first->intern((*table.second)[i]) != (int32_t) i) {
+                throw ScriptCache::ScriptCacheError("Script cache: The symbols do not match the script.");
+            }
+        }
+        if (table.first->size() != table.second->size()) {
+            throw ScriptCache::ScriptCacheError("Script cache: The symbols do not match the script.");
+        }
+    }
+    _eval.vars() = vars;
+    _eval.funcs() = funcs;
+    for (const auto& action : arg_cache.actions) {
+        _lineNum = action.line;
+        _section = action.section;
+        switch (action.type) {
+            case 'G':
+                _strings.emplace(action.name, action.text);
+                break;
+            case 'L':
+                _lists.emplace(action.name, action.list);
+                break;
+            case 'I':
+                _runInit(action.prog, action.text);
+                break;
+            case 'T':
+                _output->text(action.text);
+                break;
+            case 'P':
+                _printStr.emplace_back(action.text);
+                break;
+            case 'R':
+                if (_profiler) {
+                    _profiler->setSource(action.line, _section, action.text);
+                }
+                _addRoutine(ASTReader::Program(action.prog));
+                break;
+        }
+    }
+    _snapshot.reset();
 }
 
 template<class DataType>
@@ -62,11 +544,15 @@ bool Interpreter::_readGenSec(const std::string& arg_buf) {
     std::vector<std::string> list, str;
     if (x3::phrase_parse(arg_buf.begin(), arg_buf.end(), strF, x3::ascii::space, str)) {
         _strings.emplace(str.at(0), str.at(1));
+        _record('G', str.at(0), str.at(1));
+        _snapshot.reset();
         return true;
     } else if (x3::phrase_parse(arg_buf.begin(), arg_buf.end(), listF, x3::ascii::space, list)) {
         std::string key = list.at(0);
         list.erase(list.begin());
+        _record('L', key, "", list);
         _lists.emplace(key, list);
+        _snapshot.reset();
         return true;
     }
     return false;
@@ -82,41 +568,57 @@ bool Interpreter::_readInitSec(const std::string& arg_buf) {
         AST::Expression ast;
         try {
             if (x3::phrase_parse(eq.begin(), eq.end(), Parser::Expression, x3::ascii::space, ast)) {
-                _eval(ast);
-                if (_continue || _break) {
-                    _continue = false;
-                    _break = false;
-                    _section = 'N';
+                if (_writer) {
+                    return true;
                 }
+                ASTReader::Program prog = ASTReader::Compiler::compile(ast, _eval.vars(), _eval.funcs());
+                prog.line = _lineNum;
+                _record('I', "", eq, {}, prog);
+                _runInit(prog, eq);
                 return true;
             }
         } catch (const x3::expectation_failure<std::string::iterator>& arg_e) {
             throw InterpreterError(arg_e, eq);
         }
     } else if (x3::phrase_parse(arg_buf.begin(), arg_buf.end(), printStrF, x3::ascii::space, printStr)) {
-        _os << printStr << std::endl;
+        if (!_writer) {
+            _output->text(printStr);
+        }
+        _record('T', "", printStr);
         return true;
     }
     return false;
 }
 
-bool Interpreter::_readDataSec(const std::string& arg_buf) {
-    namespace x3 = boost::spirit::x3;
-    auto sp = x3::omit[*x3::ascii::space];
-
-    _getData(_strings, "RECORD_DELIM", _recordDelim);
-    auto recordF = (x3::double_ % _recordDelim) >> sp >> !x3::char_;
-    std::vector<double> recordVals;
-    _getData(_lists, "RECORD_VARS", _recordVarNames);
-    if (x3::parse(arg_buf.begin(), arg_buf.end(), recordF, recordVals)) {
-        if (recordVals.size() == _recordVarNames.size()) {
-            _mainFunc(_recordVarNames, recordVals);
-        } else {
-            throw InterpreterError("Data format error.");
+bool Interpreter::_readDataSec(const char* arg_first, const char* arg_last, const char* arg_textFirst, const char* arg_textLast, const int& arg_line, const std::streamoff& arg_offset) {
+    if (!_recordReader) {
+        _getData(_strings, "RECORD_DELIM", _recordDelim);
+        _getData(_lists, "RECORD_VARS", _recordVarNames);
+        _getSlots(_recordVarNames, _recordVarSlots);
+        _recordReader.reset(new RecordReader(_recordDelim, _recordVarNames.size()));
+        _recordVals.resize(_recordVarNames.size());
+    }
+    size_t nVals;
+    {
+        Profiler::Scope scope(_profiler ? _profiler->records() : nullptr);
+        nVals = _recordReader->read(arg_first, arg_last, _recordVals.data());
+    }
+    if (nVals == RecordReader::npos) {
+        return false;
+    }
+    if (nVals != _recordVals.size()) {
+        throw InterpreterError("Data format error. (" + std::to_string(nVals) + " values for " + std::to_string(_recordVals.size()) + " RECORD_VARS)");
+    }
+    _mainFunc(_recordVarSlots, _recordVals);
+    if (_isParallel && !_writer) {
+        _task.recordLines.emplace_back(arg_line);
+        _task.recordOffsets.emplace_back(arg_offset);
+        if (arg_offset < 0) {
+            _task.recordText.append(arg_textFirst, arg_textLast);
+            _task.recordEnds.emplace_back(_task.recordText.size());
         }
-        return true;
     }
-    return false;
+    return true;
 }
 
 bool Interpreter::_readOtherSec(const std::string& arg_buf) {
@@ -129,43 +631,32 @@ bool Interpreter::_readOtherSec(const std::string& arg_buf) {
         AST::Expression ast;
         try {
             if (x3::phrase_parse(eq.begin(), eq.end(), Parser::Expression, x3::ascii::space, ast)) {
-                switch (_section) {
-                    case 'B':
-                        _begRoutine.emplace_back(ast);
-                        return true;
-                    case 'M':
-                        _mainRoutine.emplace_back(ast);
-                        return true;
-                    case 'E':
-                        _endRoutine.emplace_back(ast);
-                        return true;
-                    case 'F':
-                        _finRoutine.emplace_back(ast);
-                        return true;
+                _snapshot.reset();
+                ASTReader::Program prog = ASTReader::Compiler::compile(ast, _eval.vars(), _eval.funcs());
+                prog.line = _lineNum;
+                if (_profiler) {
+                    _profiler->setSource(_lineNum, _section, eq);
                 }
+                _record('R', "", eq, {}, prog);
+                return _addRoutine(std::move(prog));
             }
         } catch (const x3::expectation_failure<std::string::iterator>& arg_e) {
             throw InterpreterError(arg_e, eq);
         }
     } else if (x3::phrase_parse(arg_buf.begin(), arg_buf.end(), printStrF, x3::ascii::space, printStr)) {
         _printStr.emplace_back(printStr);
+        _record('P', "", printStr);
         std::string temp = "print_str(" + std::to_string(_printStr.size() - .9) + ")";
         AST::Expression ast;
         x3::phrase_parse(temp.begin(), temp.end(), Parser::Expression, x3::ascii::space, ast);
-        switch (_section) {
-            case 'B':
-                _begRoutine.emplace_back(ast);
-                return true;
-            case 'M':
-                _mainRoutine.emplace_back(ast);
-                return true;
-            case 'E':
-                _endRoutine.emplace_back(ast);
-                return true;
-            case 'F':
-                _finRoutine.emplace_back(ast);
-                return true;
+        _snapshot.reset();
+        ASTReader::Program prog = ASTReader::Compiler::compile(ast, _eval.vars(), _eval.funcs());
+        prog.line = _lineNum;
+        if (_profiler) {
+            _profiler->setSource(_lineNum, _section, "print(\"" + printStr + "\")");
         }
+        _record('R', "", "print(\"" + printStr + "\")", {}, prog);
+        return _addRoutine(std::move(prog));
     }
     return false;
 }
@@ -178,50 +669,308 @@ bool Interpreter::_readDatasetVar(const std::string & arg_secVar) {
         auto secVarF = x3::double_ % _datasetDelim;
         std::vector<double> secVars;
         _getData(_lists, "DATASET_VARS", _datasetVarNames);
-        if (x3::parse(arg_secVar.begin(), arg_secVar.end(), secVarF, secVars)) {
+        bool isParsed;
+        {
+            Profiler::Scope scope(_profiler ? _profiler->datasets() : nullptr);
+            isParsed = x3::parse(arg_secVar.begin(), arg_secVar.end(), secVarF, secVars);
+        }
+        if (isParsed) {
             if (secVars.size() == _datasetVarNames.size()) {
-                _beginFunc(_datasetVarNames, secVars);
+                _getSlots(_datasetVarNames, _datasetVarSlots);
+                _beginFunc(_datasetVarSlots, secVars);
                 return true;
             } else {
                 throw InterpreterError("Dataset values format error.");
             }
         }
     } else {
-        _beginFunc(_datasetVarNames, std::vector<double>{});
+        _beginFunc(_datasetVarSlots, std::vector<double>{});
         return true;
     }
     return false;
 }
 
+bool Interpreter::_readScanSec(const std::string& arg_buf) {
+    namespace x3 = boost::spirit::x3;
+
+    const struct ScanKinds : x3::symbols<char> {
+
+        ScanKinds() {
+            add("grid", 'G')("range", 'R')("values", 'V')("lhs", 'L');
+        }
+    } scanKinds;
+
+    std::string eq = arg_buf, var;
+    char kind = 0;
+    std::vector<AST::Expression> asts;
+    auto setVar = [&var](auto& ctx) {
+        var.assign(x3::_attr(ctx).begin(), x3::_attr(ctx).end());
+    };
+    auto setKind = [&kind](auto& ctx) {
+        kind = x3::_attr(ctx);
+    };
+    auto addArg = [&asts](auto& ctx) {
+        asts.emplace_back(AST::Expression(x3::_attr(ctx)));
+    };
+    auto name = x3::raw[x3::lexeme[(x3::alpha | x3::char_('_')) >> *(x3::alnum | x3::char_('_'))]];
+    auto scanF = name[setVar] >> '=' >> scanKinds[setKind] >> '(' >> (Parser::SubstExpr[addArg] % ',') >> ')' >> !x3::char_;
+    try {
+        if (!x3::phrase_parse(eq.begin(), eq.end(), scanF, x3::ascii::space)) {
+            return false;
+        }
+    } catch (const x3::expectation_failure<std::string::iterator>& arg_e) {
+        throw InterpreterError(arg_e, eq);
+    }
+    for (const auto& axis : _scanAxes) {
+        if (axis.var == var) {
+            throw InterpreterError("SCAN: " + var + " is given twice.");
+        }
+    }
+
+    _snapshot.reset();
+    std::vector<double> args;
+    for (auto& ast : asts) {
+        args.emplace_back(_eval.execute(ASTReader::Compiler::compile(ast, _eval.vars(), _eval.funcs())));
+    }
+    _ScanAxis axis{var, kind, {}};
+    switch (kind) {
+        case 'G':
+        {
+            if (args.size() != 3) {
+                throw InterpreterError("grid: It takes (first, last, n).");
+            }
+            if (!(args[2] >= .5 && args[2] < 1e9)) {
+                throw InterpreterError("grid: The number of points must be positive and below 1e9.");
+            }
+            const long n = std::lround(args[2]);
+            for (long i = 0; i < n; i++) {
+                axis.vals.emplace_back(i + 1 == n && i != 0 ? args[1] : args[0] + (args[1] - args[0]) * i / std::max(n - 1, 1L));
+            }
+            break;
+        }
+        case 'R':
+        {
+            if (args.size() != 3) {
+                throw InterpreterError("range: It takes (first, last, step).");
+            }
+            const double n = std::floor((args[1] - args[0]) / args[2] + 1e-9);
+            if (!(n >= 0. && n < 1e9)) {
+                throw InterpreterError("range: The step must be nonzero and toward last.");
+            }
+            for (long i = 0; i <= (long) n; i++) {
+                axis.vals.emplace_back(args[0] + args[2] * i);
+            }
+            break;
+        }
+        case 'V':
+            axis.vals = args;
+            break;
+        case 'L':
+            if (args.size() != 3 && args.size() != 4) {
+                throw InterpreterError("lhs: It takes (lower, upper, n[, seed]).");
+            }
+            if (!(args[2] >= .5 && args[2] < 1e9)) {
+                throw InterpreterError("lhs: The number of points must be positive and below 1e9.");
+            }
+            if (args.size() == 4 && !(args[3] > -.5 && args[3] < 0x1p63)) {
+                throw InterpreterError("lhs: The seed must be a nonnegative integer.");
+            }
+            axis.vals = {args[0], args[1], (double) std::lround(args[2]), args.size() == 4 ? std::round(args[3]) : 0.};
+            break;
+    }
+    _scanAxes.emplace_back(std::move(axis));
+    return true;
+}
+
+void Interpreter::_runScan() {
+    std::vector<_ScanAxis> axes;
+    axes.swap(_scanAxes);
+    _getData(_lists, "DATASET_VARS", _datasetVarNames);
+    _getSlots(_datasetVarNames, _datasetVarSlots);
+
+    // The points are the product of the axes, the first one outermost,
+    // except that the lhs() axes are sampled together as one dimension
+    // placed at the first of them.
+    struct Dimension {
+        std::vector<size_t> vars;
+        std::vector<std::vector<double>> columns;
+    };
+    std::vector<Dimension> dims;
+    const _ScanAxis* lhs = nullptr;
+    size_t lhsDim = 0;
+    for (const auto& axis : axes) {
+        auto it = std::find(_datasetVarNames.begin(), _datasetVarNames.end(), axis.var);
+        if (it == _datasetVarNames.end()) {
+            throw InterpreterError("SCAN: " + axis.var + " is not in DATASET_VARS.");
+        }
+        const size_t var = it - _datasetVarNames.begin();
+        if (axis.kind != 'L') {
+            dims.push_back(Dimension{{var}, {axis.vals}});
+            continue;
+        }
+        if (!lhs) {
+            lhs = &axis;
+            lhsDim = dims.size();
+            dims.emplace_back();
+        } else if (axis.vals[2] != lhs->vals[2] || axis.vals[3] != lhs->vals[3]) {
+            throw InterpreterError("lhs: All the lhs() axes must have the same n and seed.");
+        }
+        dims[lhsDim].vars.emplace_back(var);
+    }
+    if (axes.size() != _datasetVarNames.size()) {
+        for (const auto& name : _datasetVarNames) {
+            if (std::none_of(axes.begin(), axes.end(), [&name](const _ScanAxis & arg_axis) {
+                    return arg_axis.var == name;
+                })) {
+                throw InterpreterError("SCAN: " + name + " is not given.");
+            }
+        }
+    }
+    if (lhs) {
+        // Each axis is split into n strata, one point in each, and the
+        // strata are shuffled independently. The generator is used
+        // directly so that a seed gives the same points everywhere.
+        const size_t n = (size_t) lhs->vals[2];
+        std::mt19937_64 gen((uint64_t) lhs->vals[3]);
+        std::vector<size_t> strata(n);
+        for (const auto& axis : axes) {
+            if (axis.kind != 'L') {
+                continue;
+            }
+            for (size_t i = 0; i < n; i++) {
+                strata[i] = i;
+            }
+            for (size_t i = n - 1; i > 0; i--) {
+                std::swap(strata[i], strata[gen() % (i + 1)]);
+            }
+            std::vector<double> column(n);
+            for (size_t i = 0; i < n; i++) {
+                const double u = std::ldexp(double(gen() >> 11), -53);
+                column[i] = axis.vals[0] + (axis.vals[1] - axis.vals[0]) * (strata[i] + u) / n;
+            }
+            dims[lhsDim].columns.emplace_back(std::move(column));
+        }
+    }
+
+    std::vector<size_t> pos(dims.size(), 0);
+    std::vector<double> point(_datasetVarNames.size());
+    while (true) {
+        for (size_t dim = 0; dim < dims.size(); dim++) {
+            for (size_t i = 0; i < dims[dim].vars.size(); i++) {
+                point[dims[dim].vars[i]] = dims[dim].columns[i][pos[dim]];
+            }
+        }
+        if (_section == 'D') {
+            _endFunc();
+        }
+        _beginFunc(_datasetVarSlots, point);
+        _section = 'D';
+        size_t dim = dims.size();
+        while (dim > 0 && ++pos[dim - 1] == dims[dim - 1].columns[0].size()) {
+            pos[dim - 1] = 0;
+            dim--;
+        }
+        if (dim == 0) {
+            break;
+        }
+    }
+}
+
+void Interpreter::_readRGData(const RGData& arg_data) {
+    auto checkNames = [ this ](const std::string& arg_name, std::vector<std::string>& arg_names, const std::vector<std::string>& arg_dataNames) {
+        auto it_names = _lists.find(arg_name);
+        if (arg_names.size() == 0 && it_names != _lists.end()) {
+            arg_names = std::move(it_names->second);
+        }
+        if (arg_names.size() != 0 && arg_names != arg_dataNames) {
+            throw InterpreterError(arg_name + " does not match the RG data.");
+        }
+        arg_names = arg_dataNames;
+    };
+    checkNames("DATASET_VARS", _datasetVarNames, arg_data.datasetVarNames());
+    checkNames("RECORD_VARS", _recordVarNames, arg_data.recordVarNames());
+    _getSlots(_datasetVarNames, _datasetVarSlots);
+    _getSlots(_recordVarNames, _recordVarSlots);
+
+    size_t nVars = _recordVarNames.size();
+    std::vector<double> recordVals(nVars);
+    for (size_t i = 0; i < arg_data.size(); i++) {
+        if (_section == 'D') {
+            _endFunc();
+        }
+        const double* datasetVals = arg_data.datasetVals(i);
+        _beginFunc(_datasetVarSlots, std::vector<double>(datasetVals, datasetVals + arg_data.nDatasetVals(i)));
+        _section = 'D';
+        std::vector<const double*> columns;
+        for (size_t var = 0; var < nVars; var++) {
+            columns.emplace_back(arg_data.column(i, var));
+        }
+        if (!_writer && !_isParallel) {
+            _mainColumns(_recordVarSlots, columns, arg_data.nRecords(i));
+        } else {
+            for (size_t rec = 0; rec < arg_data.nRecords(i) && _section == 'D'; rec++) {
+                for (size_t var = 0; var < nVars; var++) {
+                    recordVals[var] = columns[var][rec];
+                }
+                _mainFunc(_recordVarSlots, recordVals);
+            }
+        }
+    }
+}
+
 Interpreter::Interpreter(std::istream& arg_is, std::ostream & arg_os)
-: _is(arg_is), _os(arg_os), _section('N'), _recordDelim(""), _datasetDelim(""), _outputDelim(""), _break(false), _continue(false) {
+: _is(arg_is), _os(arg_os), _columnEval(_eval), _section('N'), _recordDelim(""), _datasetDelim(""), _outputDelim(""), _break(false), _continue(false), _stopped(false), _isParallel(false), _writer(nullptr), _columnar(false), _columnMode('R'), _lineNum(0), _modelMode('N'), _output(new TextSink(arg_os)), _rgRun{0., 0., 0., 0}, _nOptimized{0, 0, 0, 0}, _nHoisted(0) {
 
-    auto printFunc = [ this ](const std::vector<double>& arg_x) {
-        _getData(_strings, "OUTPUT_DELIM", _outputDelim);
-        bool isFirst = true;
-        for (const auto& elem : arg_x) {
-            _os << (isFirst ? (isFirst = false, "") : _outputDelim) << elem;
+    auto printFunc = [ this ](const ASTReader::ArgSpan& arg_x) {
+        if (_printSink) {
+            _printSink(arg_x);
+            return arg_x.back();
         }
-        _os << std::endl;
+        _getData(_strings, "OUTPUT_DELIM", _outputDelim);
+        _output->row(arg_x, _outputDelim);
         return arg_x.back();
     };
-    auto printStrFunc = [ this ](const std::vector<double>& arg_x) {
-        _os << _printStr.at((int) (arg_x.front() + 0.5)) << std::endl;
+    auto printStrFunc = [ this ](const ASTReader::ArgSpan& arg_x) {
+        _output->text(_printStr.at((int) (arg_x.front() + 0.5)));
         return 0.;
     };
-    auto continueFunc = [ this ](const std::vector<double>& arg_x) {
+    auto continueFunc = [ this ](const ASTReader::ArgSpan& arg_x) {
         _continue = true;
         return 0.;
     };
-    auto breakFunc = [ this ](const std::vector<double>& arg_x) {
+    auto continueBatch = [](const ASTReader::BatchArgs& arg_x, double* arg_result) {
+        std::fill(arg_result, arg_result + arg_x.size(), 0.);
+        std::fill(arg_x.active(), arg_x.active() + arg_x.size(), false);
+    };
+    auto breakFunc = [ this ](const ASTReader::ArgSpan& arg_x) {
         _continue = true;
         _break = true;
         return 0.;
     };
+    auto rgeFunc = [ this ](const ASTReader::ArgSpan& arg_x) {
+        if (arg_x.size() > 4) {
+            throw InterpreterError("rge: Too many arguments.");
+        }
+        const double nPoints = arg_x.at(2) + 0.5;
+        if (!(nPoints < 1e9)) {
+            throw InterpreterError("rge: The number of points must be finite and below 1e9.");
+        }
+        _rgRun = _RGRun{arg_x.at(0), arg_x.at(1), arg_x.size() == 4 ? arg_x.at(3) : 1e-10, nPoints >= 1. ? (size_t) nPoints : 0};
+        return 0.;
+    };
+    auto exitFunc = [](const ASTReader::ArgSpan& arg_x) -> double {
+        // Unwinds to analyze() rather than leaving the buffered rows.
+        throw Exit();
+    };
     setFunc("print", -1, printFunc);
     setFunc("print_str", 1, printStrFunc);
-    setFunc("continue", 0, continueFunc);
+    setFunc("continue", 0, continueFunc, continueBatch);
     setFunc("break", 0, breakFunc);
+    setFunc("rge", -3, rgeFunc);
+    setFunc("exit", 0, exitFunc);
+    for (const auto& name : {"print", "print_str", "continue", "break", "rge", "exit"}) {
+        setEffect(name, 'N');
+    }
 }
 
 void Interpreter::InterpreterError::errorMsg(std::ostream & arg_out) const {
@@ -239,7 +988,48 @@ void Interpreter::InterpreterError::errorMsg(std::ostream & arg_out) const {
     }
 }
 
-void Interpreter::analyze() {
+void Interpreter::setJobs(const size_t& arg_jobs) {
+    _drain();
+    _pool.reset();
+    _workers.clear();
+    _snapshot.reset();
+    if (arg_jobs > 1) {
+        for (size_t i = 0; i < arg_jobs; i++) {
+            auto worker = std::unique_ptr<_Worker>(new _Worker());
+            worker->interp = _clone(worker->os);
+            worker->interp->setProfile(bool(_profiler));
+            _workers.emplace_back(std::move(worker));
+        }
+        _pool.reset(new ThreadPool(arg_jobs));
+    }
+}
+
+void Interpreter::setProfile(const bool& arg_profile) {
+    _profiler.reset(arg_profile ? new Profiler() : nullptr);
+    _eval.setProfiler(_profiler.get());
+    for (auto& worker : _workers) {
+        worker->interp->setProfile(arg_profile);
+    }
+}
+
+void Interpreter::printProfile(std::ostream& arg_os) const {
+    if (!_profiler) {
+        return;
+    }
+    Profiler total(*_profiler);
+    for (const auto& worker : _workers) {
+        if (worker->interp->_profiler) {
+            total.merge(*worker->interp->_profiler);
+        }
+    }
+    std::vector<std::string> funcNames;
+    for (size_t i = 0; i < _eval.funcs().size(); i++) {
+        funcNames.emplace_back(_eval.funcs().name(i));
+    }
+    total.report(arg_os, funcNames);
+}
+
+void Interpreter::load() {
     namespace x3 = boost::spirit::x3;
 
     auto sp = x3::omit[*x3::ascii::space];
@@ -250,55 +1040,271 @@ void Interpreter::analyze() {
             add("DATASET", 'D')("GENERAL", 'G')
                     ("INITIALIZE", 'I')("BEGIN_ROUTINE", 'B')
                     ("END_ROUTINE", 'E')("MAIN_ROUTINE", 'M')
-                    ("FINALIZE", 'F');
+                    ("FINALIZE", 'F')("SCAN", 'S');
         }
     } secNames;
 
     auto entryF = sp >> x3::raw[*(~x3::char_("#\\"))] >> '\\';
     auto secF = '[' >> sp >> secNames >> sp > ']' >> sp >> -('(' >> *(~x3::char_(')')) > ')') >> sp >> !x3::char_;
 
-    std::string strBuf;
+    // One entry of the input: its text with the continuation lines joined,
+    // its last raw line for the error messages, and its line numbers.
+    struct Entry {
+        std::string buf, strBuf;
+        int line, lastLine;
+    };
     int lineNum = 0;
-    while (std::getline(_is, strBuf)) {
-        lineNum++;
-        std::string buf;
-        try {
-            while (x3::parse(strBuf.begin(), strBuf.end(), entryF, buf) && std::getline(_is, strBuf)) {
-                lineNum++;
+    auto fail = [this](const InterpreterError& arg_e, const int& arg_line) {
+        if (arg_e.isReported()) {
+            throw arg_e;
+        }
+        _drain();
+        _os << "Wrong syntax in line " << arg_line << ":" << std::endl;
+        arg_e.errorMsg(_os);
+        throw arg_e;
+    };
+    LineReader lines(_is);
+    const char* first;
+    const char* last;
+    auto getLine = [&](std::string & arg_line) {
+        if (!lines.next(first, last)) {
+            return false;
+        }
+        arg_line.assign(first, last);
+        return true;
+    };
+    auto next = [&](Entry & arg_entry) {
+        while (lines.next(first, last)) {
+            lineNum++;
+            if (_section == 'D') {
+                // Records are read in place. Anything else, including
+                // records with comments or continuations, goes on below.
+                try {
+                    _lineNum = lineNum;
+                    if (_readDataSec(first, last, first, last, lineNum, lines.offset())) {
+                        continue;
+                    }
+                } catch (const InterpreterError& arg_e) {
+                    fail(arg_e, lineNum);
+                }
             }
-            if (buf.size() == 0) {
-                continue;
+            arg_entry.strBuf.assign(first, last);
+            arg_entry.line = lineNum;
+            arg_entry.buf.clear();
+            if (arg_entry.strBuf.find_first_of("#\\") == std::string::npos) {
+                // A line with neither a comment nor a continuation is the
+                // entry itself without leading spaces.
+                size_t pos = 0;
+                while (pos < arg_entry.strBuf.size() && std::isspace((unsigned char) arg_entry.strBuf[pos])) {
+                    pos++;
+                }
+                arg_entry.buf.assign(arg_entry.strBuf, pos, std::string::npos);
+            } else {
+                while (x3::parse(arg_entry.strBuf.begin(), arg_entry.strBuf.end(), entryF, arg_entry.buf) && getLine(arg_entry.strBuf)) {
+                    lineNum++;
+                }
             }
-
+            arg_entry.lastLine = lineNum;
+            if (arg_entry.buf.size() != 0) {
+                return true;
+            }
+        }
+        return false;
+    };
+    auto read = [&](const Entry & arg_entry) {
+        _lineNum = arg_entry.line;
+        const std::string& buf = arg_entry.buf;
+        try {
             std::pair<char, std::string> secName;
 
-            if (x3::parse(buf.begin(), buf.end(), secF, secName)) {
+            if (buf[0] == '[' && x3::parse(buf.begin(), buf.end(), secF, secName)) {
+                if (_section == 'S') {
+                    _runScan();
+                }
                 if (_section == 'D') {
                     _endFunc();
                 }
+                if (secName.first != 'D') {
+                    _drain();
+                }
                 if (secName.first == 'D') {
                     if (!_readDatasetVar(secName.second)) {
-                        throw InterpreterError(strBuf);
+                        throw InterpreterError(arg_entry.strBuf);
                     }
                 }
                 _section = secName.first;
-            } else if (_section == 'D' && _readDataSec(buf)) {
+                _record('H', "", "");
+            } else if (_section == 'D' && _readDataSec(buf.data(), buf.data() + buf.size(), arg_entry.strBuf.data(), arg_entry.strBuf.data() + arg_entry.strBuf.size(), arg_entry.lastLine, lines.offset())) {
             } else if (_section == 'I' && _readInitSec(buf)) {
             } else if (_section == 'G' && _readGenSec(buf)) {
+            } else if (_section == 'S' && _readScanSec(buf)) {
             } else if (_section != 'N' && _readOtherSec(buf)) {
             } else {
-                throw InterpreterError(strBuf);
+                throw InterpreterError(arg_entry.strBuf);
+            }
+        } catch (const InterpreterError& arg_e) {
+            fail(arg_e, arg_entry.lastLine);
+        }
+    };
+
+    Entry entry;
+    bool hasEntry = next(entry);
+    if ((!_cacheDir.empty() || _modelMode != 'N') && !_writer) {
+        // The script part ends at the first [DATASET] or [SCAN]. Its key covers
+        // everything that changes the compiled programs: the versions and
+        // the builtins, which fix the slots, and the entries with their
+        // line numbers.
+        std::vector<Entry> script;
+        std::string text = "ELVAS " + std::to_string(ELVAS_VERSION_MAJOR) + "." + std::to_string(ELVAS_VERSION_MINOR) + " " + std::to_string(ScriptCache::version) + "\n";
+        for (size_t i = 0; i < _eval.vars().size(); i++) {
+            text += _eval.vars().name(i) + ",";
+        }
+        text += "\n";
+        for (size_t i = 0; i < _eval.funcs().size(); i++) {
+            text += _eval.funcs().name(i) + ",";
+        }
+        text += "\n";
+        std::pair<char, std::string> secName;
+        while (hasEntry && !(x3::parse(entry.buf.begin(), entry.buf.end(), secF, secName) && (secName.first == 'D' || secName.first == 'S'))) {
+            text += std::to_string(entry.line) + ":" + entry.buf + "\n";
+            script.emplace_back(std::move(entry));
+            hasEntry = next(entry);
+        }
+        const std::string key = ScriptCache::key(text);
+        const std::string path = _cacheDir + "/" + key + ".elc";
+        ScriptCache cache;
+        bool isCached = false;
+        if (!_cacheDir.empty()) {
+            try {
+                isCached = cache.read(path, text);
+                if (isCached) {
+                    _replay(cache);
+                }
+            } catch (const ScriptCache::ScriptCacheError& arg_e) {
+                std::cerr << "Warning: " << arg_e.what() << " The script is parsed again." << std::endl;
+                std::remove(path.c_str());
+                isCached = false;
+            }
+        }
+        if (!isCached) {
+            if (!_cacheDir.empty()) {
+                _recording.reset(new ScriptCache());
+            }
+            try {
+                for (const auto& scriptEntry : script) {
+                    read(scriptEntry);
+                }
+            } catch (...) {
+                _recording.reset();
+                throw;
+            }
+            if (_recording) {
+                for (size_t i = 0; i < _eval.vars().size(); i++) {
+                    _recording->vars.emplace_back(_eval.vars().name(i));
+                }
+                for (size_t i = 0; i < _eval.funcs().size(); i++) {
+                    _recording->funcs.emplace_back(_eval.funcs().name(i));
+                }
+                _recording->write(path, text);
+                _recording.reset();
+            }
+        }
+        if (_modelMode != 'N') {
+            _useModel(key);
+            if (_modelMode == 'C') {
+                return;
+            }
+        }
+    }
+    while (hasEntry) {
+        read(entry);
+        hasEntry = next(entry);
+    }
+    try {
+        if (_section == 'S') {
+            _runScan();
+        }
+        // The errors of the datasets run by the workers are reported as
+        // they would be if read serially.
+        _drain();
+    } catch (const InterpreterError& arg_e) {
+        fail(arg_e, lineNum);
+    }
+}
+
+void Interpreter::analyze() {
+    try {
+        load();
+        try {
+            for (const auto& data : _rgData) {
+                _readRGData(*data);
             }
         } catch (const InterpreterError& arg_e) {
-            _os << "Wrong syntax in line " << lineNum << ":" << std::endl;
+            _drain();
             arg_e.errorMsg(_os);
             throw arg_e;
         }
+        _endFunc();
+        _finFunc();
+    } catch (const Exit&) {
+        // The datasets after the one calling exit() are not emitted.
+        _pending.clear();
+        _output->flush();
+    } catch (...) {
+        // The rows printed before the error are not flushed yet.
+        _output->flush();
+        throw;
+    }
+};
+
+void Interpreter::runDataset(const std::vector<double>& arg_datasetVals, const double* arg_records, const size_t& arg_nRecords) {
+    if (_pool || _writer) {
+        throw InterpreterError("runDataset: Not available with worker threads or RG data conversion.");
+    }
+    if (_section == 'D') {
+        _endFunc();
+    }
+    if (arg_datasetVals.size() != 0) {
+        _getData(_lists, "DATASET_VARS", _datasetVarNames);
+        if (arg_datasetVals.size() != _datasetVarNames.size()) {
+            throw InterpreterError("Dataset values format error.");
+        }
+        _getSlots(_datasetVarNames, _datasetVarSlots);
+    }
+    _beginFunc(_datasetVarSlots, arg_datasetVals);
+    _section = 'D';
+    if (arg_nRecords > 0) {
+        _getData(_lists, "RECORD_VARS", _recordVarNames);
+        _getSlots(_recordVarNames, _recordVarSlots);
     }
-    _endFunc();
+    const size_t nVars = _recordVarNames.size();
+    std::vector<double> recordVals(nVars);
+    for (size_t rec = 0; rec < arg_nRecords && _section == 'D'; rec++) {
+        std::copy(arg_records + rec * nVars, arg_records + (rec + 1) * nVars, recordVals.begin());
+        _mainFunc(_recordVarSlots, recordVals);
+    }
+    if (_section == 'D') {
+        _endFunc();
+    }
+    _section = 'N';
+}
+
+void Interpreter::finalize() {
+    if (_section == 'D') {
+        _endFunc();
+    }
+    _section = 'N';
     _finFunc();
+}
 
-};
+void Interpreter::convert(RGDataWriter& arg_writer) {
+    _writer = &arg_writer;
+    analyze();
+    _writer = nullptr;
+    _getData(_lists, "DATASET_VARS", _datasetVarNames);
+    _getData(_lists, "RECORD_VARS", _recordVarNames);
+    arg_writer.close(_datasetVarNames, _recordVarNames);
+}
 
 void Interpreter::interactive() {
     namespace x3 = boost::spirit::x3;
@@ -7,6 +7,7 @@
 
 #include "include/version.h"
 #include "include/elvas_script.h"
+#include "include/chain_stream.h"
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -23,6 +24,8 @@ int main(int argc, char** argv) {
             "  (filein/stdout): ./elvas [INPUT1] [INPUT2] ...\n"
             "  (stdin/fileout): ./elvas -o [OUTPUT]\n"
             " (filein/fileout): ./elvas -o [OUTPUT] [INPUT1] [INPUT2] ...\n"
+            "   (RG data conv.): ./elvas -c [RGDATA] [INPUT1] [INPUT2] ...\n"
+            "  (model compile): ./elvas --compile -o [MODEL] [INPUT1] [INPUT2] ...\n"
             "For details, see the attached manual.\n\n"
             "Allowed options";
     po::options_description desc(usage);
@@ -30,6 +33,16 @@ int main(int argc, char** argv) {
             ("output,o", po::value<string>(), "output file")
             ("help,h", "display this help message")
             ("version,v", "output version information")
+            ("convert,c", po::value<string>(), "convert RG data into a binary file")
+            ("jobs,j", po::value<size_t>()->default_value(1), "number of threads running datasets")
+            ("columnar", "run MAIN_ROUTINE on whole datasets at once")
+            ("cache", po::value<string>(), "directory of compiled scripts, reused when a script is run again")
+            ("compile", "compile the routines of the script into the native model given by -o")
+            ("model", po::value<string>(), "run the routines with a native model compiled from the same script")
+            ("format", po::value<string>()->default_value("text"), "output format of print: text, csv or binary")
+            ("kernels", po::value<string>()->default_value("closed"), "quantum corrections from closed forms or from tables: closed or table")
+            ("profile", "print the time spent per line, builtin and section to stderr")
+            ("explain", "print the constants folded and the subexpressions shared in the routines to stderr")
             ("no_header,n", "disable header printing");
 
     po::options_description hidden;
@@ -72,37 +85,66 @@ int main(int argc, char** argv) {
         return 0;
     }
 
-    stringstream ss;
     ofstream ofs;
+    vector<string> textInputs;
+    vector<shared_ptr<const RGData>> rgData;
     if (vm.count("input")) {
         for (const auto& in : vm["input"].as<vector < string >> ()) {
-            ifstream ifs(in);
-            if (ifs) {
-                ss << ifs.rdbuf();
+            if (RGData::isRGData(in)) {
+                rgData.emplace_back(make_shared<const RGData>(in));
             } else {
-                throw runtime_error("File open error. (" + in + ")");
+                textInputs.emplace_back(in);
             }
         }
     }
+    ChainStream ss(textInputs);
+    if (vm.count("convert")) {
+        RGDataWriter writer(vm["convert"].as<string>());
+        ElvasScript elvas(ss, cout);
+        elvas.convert(writer);
+        return 0;
+    }
+    if (vm["kernels"].as<string>() == "table") {
+        Elvas::setKernels('T');
+    } else if (vm["kernels"].as<string>() != "closed") {
+        throw runtime_error("Unknown kernels. (" + vm["kernels"].as<string>() + ")");
+    }
+    if (vm.count("compile")) {
+        if (!vm.count("output")) {
+            throw runtime_error("No model file given by -o.");
+        }
+        ostringstream discard;
+        ElvasScript elvas(vm.count("input") ? static_cast<istream&> (ss) : cin, discard);
+        elvas.compileModel(vm["output"].as<string>());
+        return 0;
+    }
     if (vm.count("output")) {
-        ofs.open(vm["output"].as<string>());
+        ofs.open(vm["output"].as<string>(), vm["format"].as<string>() == "binary" ? ios::out | ios::binary : ios::out);
         if (!ofs) {
             throw runtime_error("File open error. (" + vm["output"].as<string>() + ")");
         }
     }
 
-    if (vm.count("input") && vm.count("output")) {
-        ElvasScript elvas(ss, ofs);
-        elvas.analyze();
-    } else if ((!vm.count("input")) && vm.count("output")) {
-        ElvasScript elvas(std::cin, ofs);
-        elvas.analyze();
-    } else if (vm.count("input")&&(!vm.count("output"))) {
-        ElvasScript elvas(ss, std::cout);
-        elvas.analyze();
-    } else {
-        ElvasScript elvas(std::cin, std::cout);
-        elvas.analyze();
+    istream& is = vm.count("input") ? static_cast<istream&> (ss) : cin;
+    ostream& os = vm.count("output") ? static_cast<ostream&> (ofs) : cout;
+    ElvasScript elvas(is, os);
+    elvas.setJobs(vm["jobs"].as<size_t>());
+    elvas.setColumnar(vm.count("columnar"));
+    elvas.setProfile(vm.count("profile"));
+    elvas.setOutputFormat(vm["format"].as<string>());
+    if (vm.count("cache")) {
+        elvas.setCacheDir(vm["cache"].as<string>());
+    }
+    if (vm.count("model")) {
+        elvas.setModel(vm["model"].as<string>());
+    }
+    for (const auto& data : rgData) {
+        elvas.addRGData(data);
+    }
+    elvas.analyze();
+    elvas.printProfile(cerr);
+    if (vm.count("explain")) {
+        elvas.printExplain(cerr);
     }
 
     return 0;
@@ -0,0 +1,444 @@
+/**
+ * @file native_model.cpp
+ * @brief Routines compiled ahead of time into shared objects
+ * @date Created on: 2026/10/17, 23:58
+ */
+
+#include "include/native_model.h"
+#include "include/optimizer.h"
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+#ifndef ELVAS_CXX
+#define ELVAS_CXX "c++"
+#endif
+
+namespace {
+    // The host side of the layout is in compiler.h and native_model.h.
+    const char* const prologue =
+            "// Generated by elvas --compile.\n"
+            "#include <cmath>\n"
+            "#include <cstddef>\n"
+            "#include <cstdint>\n"
+            "\n"
+            "struct ElvasNativeHost {\n"
+            "    double* frame;\n"
+            "    char* isSet;\n"
+            "    double (*load)(ElvasNativeHost*, int32_t);\n"
+            "    double (*call)(ElvasNativeHost*, int32_t, const double*, size_t);\n"
+            "    void* eval;\n"
+            "};\n"
+            "\n"
+            "struct ElvasModelLine {\n"
+            "    char section;\n"
+            "    int32_t index, line;\n"
+            "    double (*run)(ElvasNativeHost*);\n"
+            "};\n"
+            "\n"
+            "struct ElvasModelInfo {\n"
+            "    int32_t abi;\n"
+            "    const char* key;\n"
+            "    int32_t nVars;\n"
+            "    const char* const* vars;\n"
+            "    int32_t nFuncs;\n"
+            "    const char* const* funcs;\n"
+            "    int32_t nNatives;\n"
+            "    const char* const* natives;\n"
+            "    const char* const* nativeExprs;\n"
+            "    const char* const* nativeTypes;\n"
+            "    void (*bind)(void (*const*)());\n"
+            "    int32_t nLines;\n"
+            "    const ElvasModelLine* lines;\n"
+            "};\n"
+            "\n"
+            "// As NTools::powInt.\n"
+            "static double powInt(double base, int32_t exp) {\n"
+            "    double result = 1.;\n"
+            "    uint32_t tester = 0xFFFFFFFF;\n"
+            "    uint32_t extractor = 1;\n"
+            "    uint32_t absexp = exp > 0 ? exp : -exp;\n"
+            "    while (absexp & tester) {\n"
+            "        result = (absexp & extractor) ? result * base : result;\n"
+            "        base *= base;\n"
+            "        extractor <<= 1;\n"
+            "        tester <<= 1;\n"
+            "    }\n"
+            "    return exp > 0 ? result : 1. / result;\n"
+            "}\n"
+            "\n"
+            "#define LOAD(s) (h->isSet[s] ? h->frame[s] : h->load(h, s))\n"
+            "\n";
+
+    std::string reg(const int32_t& arg_reg) {
+        return "r" + std::to_string(arg_reg);
+    }
+
+    std::string literal(const double& arg_num) {
+        if (std::isnan(arg_num)) {
+            return "NAN";
+        }
+        if (std::isinf(arg_num)) {
+            return arg_num > 0. ? "HUGE_VAL" : "-HUGE_VAL";
+        }
+        char buf[32];
+        std::snprintf(buf, sizeof (buf), "%.17g", arg_num);
+        std::string str(buf);
+        if (str.find_first_of(".e") == std::string::npos) {
+            str += ".";
+        }
+        return arg_num < 0. ? "(" + str + ")" : str;
+    }
+
+    std::string quote(const std::string& arg_str) {
+        std::string str = "\"";
+        for (const char& c : arg_str) {
+            if (c == '"' || c == '\\') {
+                str += '\\';
+                str += c;
+            } else if ((unsigned char) c < 0x20 || (unsigned char) c >= 0x7F) {
+                char buf[8];
+                std::snprintf(buf, sizeof (buf), "\\%03o", (unsigned char) c);
+                str += buf;
+            } else {
+                str += c;
+            }
+        }
+        return str + "\"";
+    }
+
+    std::string table(const std::string& arg_name, const std::vector<std::string>& arg_strs) {
+        std::string str = "static const char* const " + arg_name + "[] = {";
+        for (const auto& s : arg_strs) {
+            str += quote(s) + ", ";
+        }
+        return str + "nullptr};\n";
+    }
+
+    std::string shellQuote(const std::string& arg_str) {
+        std::string str = "'";
+        for (const char& c : arg_str) {
+            str += c == '\'' ? std::string("'\\''") : std::string(1, c);
+        }
+        return str + "'";
+    }
+}
+
+const int32_t ASTReader::NativeModel::abi;
+
+std::string ASTReader::NativeModel::_translate(const Evaluator& arg_eval, const Program& arg_prog, const std::vector<char>& arg_isDefined, std::vector<int32_t>& arg_natives) {
+    const auto& code = arg_prog.code;
+    std::vector<char> isTarget(code.size() + 1, false);
+    for (const auto& inst : code) {
+        switch (inst.op) {
+            case OpCode::Jump:
+            case OpCode::JumpIfFalse:
+            case OpCode::JumpIfTrue:
+                isTarget.at(inst.dst) = true;
+                break;
+            case OpCode::Define:
+                return "";
+            default:
+                break;
+        }
+    }
+    // The native form of a builtin, with the arguments in the registers
+    // from arg_first on, or an empty string if it has none that fits.
+    auto nativeCall = [&](const int32_t& arg_func, const size_t& arg_argNum, const int32_t& arg_first) -> std::string {
+        if (arg_func < 0 || (size_t) arg_func >= arg_eval._funcTable.size() || ((size_t) arg_func < arg_isDefined.size() && arg_isDefined[arg_func])) {
+            return "";
+        }
+        const Function& func = arg_eval._funcTable[arg_func];
+        if (!func.builtin || func.native.empty() || !func.accepts(arg_argNum) || (!func.nativeType.empty() && !func.nativePtr)) {
+            return "";
+        }
+        const std::string& expr = func.native;
+        std::string str;
+        size_t k = 0;
+        for (; k < arg_natives.size() && arg_natives[k] != arg_func; k++) {
+        }
+        for (size_t pos = 0; pos < expr.size(); pos++) {
+            if (expr[pos] != '$' || pos + 1 == expr.size()) {
+                str += expr[pos];
+            } else if (std::isdigit((unsigned char) expr[pos + 1])) {
+                size_t end = pos + 1;
+                for (; end < expr.size() && std::isdigit((unsigned char) expr[end]); end++) {
+                }
+                const size_t arg = std::stoul(expr.substr(pos + 1, end - pos - 1));
+                if (arg >= arg_argNum) {
+                    return "";
+                }
+                str += reg(arg_first + arg);
+                pos = end - 1;
+            } else if (expr[pos + 1] == '{') {
+                const size_t end = expr.find('}', pos);
+                const int32_t slot = end == std::string::npos ? -1 : arg_eval._vars.find(expr.substr(pos + 2, end - pos - 2));
+                if (slot < 0) {
+                    return "";
+                }
+                str += "LOAD(" + std::to_string(slot) + ")";
+                pos = end;
+            } else if (expr[pos + 1] == 'f' && !func.nativeType.empty()) {
+                str += "f" + std::to_string(k);
+                pos++;
+            } else {
+                return "";
+            }
+        }
+        if (k == arg_natives.size()) {
+            arg_natives.push_back(arg_func);
+        }
+        return str;
+    };
+    std::ostringstream os;
+    for (int32_t r = 0; r < arg_prog.nRegs; r++) {
+        os << (r == 0 ? "    double " : ", ") << reg(r) << " = 0.";
+    }
+    if (arg_prog.nRegs > 0) {
+        os << ";\n";
+    }
+    for (size_t pc = 0; pc < code.size(); pc++) {
+        if (isTarget[pc]) {
+            os << "L" << pc << ":\n";
+        }
+        const Instruction& inst = code[pc];
+        const std::string dst = reg(inst.dst), a = reg(inst.a), b = reg(inst.b);
+        os << "    ";
+        switch (inst.op) {
+            case OpCode::LoadNum:
+                os << dst << " = " << literal(arg_prog.numbers[inst.a]) << ";\n";
+                break;
+            case OpCode::LoadVar:
+                os << dst << " = LOAD(" << inst.a << ");\n";
+                break;
+            case OpCode::StoreVar:
+                os << "h->frame[" << inst.a << "] = " << dst << "; h->isSet[" << inst.a << "] = 1;\n";
+                break;
+            case OpCode::Move:
+                os << dst << " = " << a << ";\n";
+                break;
+            case OpCode::Neg:
+                os << dst << " = -" << a << ";\n";
+                break;
+            case OpCode::Add:
+                os << dst << " = " << a << " + " << b << ";\n";
+                break;
+            case OpCode::Mul:
+                os << dst << " = " << a << " * " << b << ";\n";
+                break;
+            case OpCode::Div:
+                os << dst << " = " << a << " / " << b << ";\n";
+                break;
+            case OpCode::Pow:
+                os << dst << " = std::pow(" << a << ", " << b << ");\n";
+                break;
+            case OpCode::PowInt:
+                os << dst << " = powInt(" << a << ", " << inst.b << ");\n";
+                break;
+            case OpCode::Less:
+                os << dst << " = " << a << " < " << b << ";\n";
+                break;
+            case OpCode::LessEq:
+                os << dst << " = " << a << " <= " << b << ";\n";
+                break;
+            case OpCode::Greater:
+                os << dst << " = " << a << " > " << b << ";\n";
+                break;
+            case OpCode::GreaterEq:
+                os << dst << " = " << a << " >= " << b << ";\n";
+                break;
+            case OpCode::Equal:
+                os << dst << " = " << a << " == " << b << ";\n";
+                break;
+            case OpCode::NotEqual:
+                os << dst << " = " << a << " != " << b << ";\n";
+                break;
+            case OpCode::Truth:
+                os << dst << " = " << a << " >= 0.5;\n";
+                break;
+            case OpCode::Jump:
+                os << "goto L" << inst.dst << ";\n";
+                break;
+            case OpCode::JumpIfFalse:
+                os << "if (!(" << a << " >= 0.5)) goto L" << inst.dst << ";\n";
+                break;
+            case OpCode::JumpIfTrue:
+                os << "if (" << a << " >= 0.5) goto L" << inst.dst << ";\n";
+                break;
+            case OpCode::Call:
+            {
+                const CallSite& site = arg_prog.calls[inst.b];
+                const std::string expr = nativeCall(site.func, site.argNum, inst.a);
+                if (!expr.empty()) {
+                    os << dst << " = " << expr << ";\n";
+                } else if (site.argNum == 0) {
+                    os << dst << " = h->call(h, " << site.func << ", nullptr, 0);\n";
+                } else {
+                    os << "{ const double x[] = {";
+                    for (size_t i = 0; i < site.argNum; i++) {
+                        os << (i == 0 ? "" : ", ") << reg(inst.a + i);
+                    }
+                    os << "}; " << dst << " = h->call(h, " << site.func << ", x, " << site.argNum << "); }\n";
+                }
+                break;
+            }
+            case OpCode::Define:
+                return "";
+        }
+    }
+    if (isTarget[code.size()]) {
+        os << "L" << code.size() << ":\n";
+    }
+    os << "    return " << (code.empty() ? std::string("0.") : reg(arg_prog.result)) << ";\n";
+    return os.str();
+}
+
+ASTReader::NativeModel::NativeModel(const std::string& arg_path) {
+#ifdef _WIN32
+    throw NativeModelError("NativeModel: Models are not supported on this platform. (" + arg_path + ")");
+#else
+    // A bare name would be looked up in the library path.
+    const std::string path = arg_path.find('/') == std::string::npos ? "./" + arg_path : arg_path;
+    void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        throw NativeModelError("NativeModel: Cannot load the model. (" + std::string(dlerror()) + ")");
+    }
+    _info = static_cast<const _Info*> (dlsym(handle, "elvas_model"));
+    if (!_info || _info->abi != abi) {
+        dlclose(handle);
+        throw NativeModelError("NativeModel: Not a model of this version of ELVAS. (" + arg_path + ")");
+    }
+#endif
+}
+
+std::string ASTReader::NativeModel::generate(const Evaluator& arg_eval, const Routines& arg_routines, const std::string& arg_key) {
+    std::vector<char> isDefined;
+    for (const auto& routine : arg_routines) {
+        Optimizer::findDefinitions(*routine.second, isDefined);
+    }
+    std::vector<int32_t> natives;
+    std::ostringstream funcs, lines;
+    size_t nLines = 0;
+    for (const auto& routine : arg_routines) {
+        for (size_t index = 0; index < routine.second->size(); index++) {
+            const Program& prog = (*routine.second)[index];
+            const std::string body = _translate(arg_eval, prog, isDefined, natives);
+            if (body.empty()) {
+                continue;
+            }
+            const std::string name = std::string("line_") + routine.first + "_" + std::to_string(index);
+            funcs << "// Line " << prog.line << "\n"
+                    << "static double " << name << "(ElvasNativeHost* h) {\n" << body << "}\n\n";
+            lines << "    {'" << routine.first << "', " << index << ", " << prog.line << ", " << name << "},\n";
+            nLines++;
+        }
+    }
+    std::vector<std::string> vars, funcNames, nativeNames, nativeExprs, nativeTypes;
+    for (size_t slot = 0; slot < arg_eval._vars.size(); slot++) {
+        vars.push_back(arg_eval._vars.name(slot));
+    }
+    for (size_t func = 0; func < arg_eval._funcs.size(); func++) {
+        funcNames.push_back(arg_eval._funcs.name(func));
+    }
+    std::ostringstream os;
+    os << prologue;
+    for (size_t k = 0; k < natives.size(); k++) {
+        const Function& func = arg_eval._funcTable[natives[k]];
+        nativeNames.push_back(arg_eval._funcs.name(natives[k]));
+        nativeExprs.push_back(func.native);
+        nativeTypes.push_back(func.nativeType);
+        if (!func.nativeType.empty()) {
+            os << "typedef " << func.nativeType.substr(0, func.nativeType.find("(*)") + 2) << "F" << k << func.nativeType.substr(func.nativeType.find("(*)") + 2) << ";\n"
+                    << "static F" << k << " f" << k << " = nullptr;\n";
+        }
+    }
+    os << "\nstatic void bind(void (*const* ptrs)()) {\n";
+    for (size_t k = 0; k < natives.size(); k++) {
+        const Function& func = arg_eval._funcTable[natives[k]];
+        if (!func.nativeType.empty()) {
+            os << "    f" << k << " = reinterpret_cast<F" << k << "> (ptrs[" << k << "]);\n";
+        }
+    }
+    os << "}\n\n" << funcs.str()
+            << table("vars", vars) << table("funcs", funcNames)
+            << table("natives", nativeNames) << table("nativeExprs", nativeExprs) << table("nativeTypes", nativeTypes)
+            << "\nstatic const ElvasModelLine lines[] = {\n" << lines.str() << "    {0, 0, 0, nullptr}\n};\n\n"
+            << "extern \"C\" const ElvasModelInfo elvas_model = {\n"
+            << "    " << abi << ", " << quote(arg_key) << ",\n"
+            << "    " << vars.size() << ", vars, " << funcNames.size() << ", funcs,\n"
+            << "    " << natives.size() << ", natives, nativeExprs, nativeTypes, bind,\n"
+            << "    " << nLines << ", lines\n"
+            << "};\n";
+    return os.str();
+}
+
+void ASTReader::NativeModel::build(const std::string& arg_source, const std::string& arg_path) {
+    const std::string source = arg_path + ".cpp";
+    {
+        std::ofstream ofs(source);
+        ofs << arg_source;
+        if (!ofs) {
+            throw NativeModelError("NativeModel: Cannot write " + source + ".");
+        }
+    }
+    const char* env = std::getenv("CXX");
+    const std::string compiler = env && *env ? env : ELVAS_CXX;
+    const std::string command = shellQuote(compiler) + " -std=c++11 -O2 -ffp-contract=off -shared -fPIC -o " + shellQuote(arg_path) + " " + shellQuote(source);
+    if (std::system(command.c_str()) != 0) {
+        throw NativeModelError("NativeModel: " + compiler + " failed to build " + arg_path + ". The source is kept in " + source + ".");
+    }
+    std::remove(source.c_str());
+}
+
+void ASTReader::NativeModel::bind(const Evaluator& arg_eval, const Routines& arg_routines, const std::string& arg_key) const {
+    if (arg_key != _info->key) {
+        throw NativeModelError("NativeModel: The model was compiled from another script.");
+    }
+    if ((size_t) _info->nVars > arg_eval._vars.size() || (size_t) _info->nFuncs > arg_eval._funcs.size()) {
+        throw NativeModelError("NativeModel: The model was compiled for other variables or builtins.");
+    }
+    for (int32_t slot = 0; slot < _info->nVars; slot++) {
+        if (arg_eval._vars.name(slot) != _info->vars[slot]) {
+            throw NativeModelError("NativeModel: The model was compiled for other variables. (" + std::string(_info->vars[slot]) + ")");
+        }
+    }
+    for (int32_t func = 0; func < _info->nFuncs; func++) {
+        if (arg_eval._funcs.name(func) != _info->funcs[func]) {
+            throw NativeModelError("NativeModel: The model was compiled for other builtins. (" + std::string(_info->funcs[func]) + ")");
+        }
+    }
+    std::vector<void (*)()> ptrs;
+    for (int32_t k = 0; k < _info->nNatives; k++) {
+        const int32_t func = arg_eval._funcs.find(_info->natives[k]);
+        if (func < 0 || (size_t) func >= arg_eval._funcTable.size() || !arg_eval._funcTable[func].builtin
+                || arg_eval._funcTable[func].native != _info->nativeExprs[k] || arg_eval._funcTable[func].nativeType != _info->nativeTypes[k]
+                || (*_info->nativeTypes[k] && !arg_eval._funcTable[func].nativePtr)) {
+            throw NativeModelError("NativeModel: The model was compiled for another builtin. (" + std::string(_info->natives[k]) + ")");
+        }
+        ptrs.push_back(arg_eval._funcTable[func].nativePtr);
+    }
+    std::vector<std::pair<Program*, double (*)(NativeHost*)>> runs;
+    for (int32_t i = 0; i < _info->nLines; i++) {
+        const _Line& line = _info->lines[i];
+        std::vector<Program>* progs = nullptr;
+        for (const auto& routine : arg_routines) {
+            if (routine.first == line.section) {
+                progs = routine.second;
+            }
+        }
+        if (!progs || line.index < 0 || (size_t) line.index >= progs->size() || (*progs)[line.index].line != line.line) {
+            throw NativeModelError("NativeModel: The model was compiled from another script. (line " + std::to_string(line.line) + ")");
+        }
+        runs.emplace_back(&(*progs)[line.index], line.run);
+    }
+    _info->bind(ptrs.data());
+    for (auto& run : runs) {
+        run.first->native = run.second;
+    }
+}
@@ -0,0 +1,825 @@
+/**
+ * @file optimizer.cpp
+ * @brief Constant folding and sharing of subexpressions in routines
+ * @date Created on: 2026/10/17, 23:55
+ */
+
+#include "include/optimizer.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace {
+
+    std::string format(const double& arg_num) {
+        std::ostringstream os;
+        os << arg_num;
+        return os.str();
+    }
+
+    bool isJump(const ASTReader::OpCode& arg_op) {
+        return arg_op == ASTReader::OpCode::Jump || arg_op == ASTReader::OpCode::JumpIfFalse || arg_op == ASTReader::OpCode::JumpIfTrue;
+    }
+
+    std::vector<char> findTargets(const ASTReader::Program& arg_prog) {
+        std::vector<char> isTarget(arg_prog.code.size() + 1, false);
+        for (const auto& inst : arg_prog.code) {
+            if (isJump(inst.op)) {
+                isTarget.at(inst.dst) = true;
+            }
+        }
+        return isTarget;
+    }
+
+    /**
+     * Registers read by an operation on values, which is any instruction
+     * but a load, a store, a move, a jump or a definition.
+     */
+    std::vector<int32_t> findOperands(const ASTReader::Program& arg_prog, const ASTReader::Instruction& arg_inst) {
+        switch (arg_inst.op) {
+            case ASTReader::OpCode::Neg:
+            case ASTReader::OpCode::Truth:
+            case ASTReader::OpCode::PowInt:
+                return {arg_inst.a};
+            case ASTReader::OpCode::Call:
+            {
+                std::vector<int32_t> operands;
+                for (size_t i = 0; i < arg_prog.calls[arg_inst.b].argNum; i++) {
+                    operands.emplace_back(arg_inst.a + i);
+                }
+                return operands;
+            }
+            default:
+                return {arg_inst.a, arg_inst.b};
+        }
+    }
+
+    // A value as in the script, with the precedence of its operator.
+    // isNumber is for a number in the script.
+    struct Text {
+        std::string str;
+        int prec = 9;
+        bool isNumber = false;
+    };
+
+    Text numberText(const double& arg_num) {
+        return Text{format(arg_num), arg_num < 0. ? 8 : 9, true};
+    }
+
+    std::string paren(const Text& arg_text, const int& arg_prec) {
+        return arg_text.prec < arg_prec ? "(" + arg_text.str + ")" : arg_text.str;
+    }
+
+    /**
+     * The text of an operation on values with the texts arg_operands.
+     * arg_func is the name of the function called, if any.
+     */
+    Text describe(const ASTReader::Instruction& arg_inst, const std::vector<const Text*>& arg_operands, const std::string& arg_func) {
+        using ASTReader::OpCode;
+        if (arg_inst.op == OpCode::Call) {
+            Text text{arg_func + "(", 9};
+            for (size_t i = 0; i < arg_operands.size(); i++) {
+                text.str += (i ? ", " : "") + arg_operands[i]->str;
+            }
+            text.str += ")";
+            return text;
+        }
+        const Text& a = *arg_operands[0];
+        switch (arg_inst.op) {
+            case OpCode::Neg:
+                return Text{"-" + paren(a, 9), 8};
+            case OpCode::Truth:
+                return Text{a.str, a.prec};
+            case OpCode::PowInt:
+                return Text{paren(a, 9) + "^" + std::to_string(arg_inst.b), 7};
+            case OpCode::Pow:
+                return Text{paren(a, 9) + "^" + paren(*arg_operands[1], 9), 7};
+            case OpCode::Mul:
+            case OpCode::Div:
+                return Text{paren(a, 5) + (arg_inst.op == OpCode::Mul ? " * " : " / ") + paren(*arg_operands[1], 6), 5};
+            case OpCode::Add:
+                if (arg_operands[1]->prec == 8) {
+                    return Text{paren(a, 4) + " - " + arg_operands[1]->str.substr(1), 4};
+                }
+                return Text{paren(a, 4) + " + " + paren(*arg_operands[1], 5), 4};
+            default:
+            {
+                const char* names[] = {"<", "<=", ">", ">=", "==", "!="};
+                return Text{paren(a, 4) + " " + names[(int) arg_inst.op - (int) OpCode::Less] + " " + paren(*arg_operands[1], 4), 3};
+            }
+        }
+    }
+
+    // Kinds of values by how often they may change: once per run, per
+    // dataset or per record.
+    char later(const char& arg_kind1, const char& arg_kind2) {
+        return std::strchr("RDE", arg_kind1) < std::strchr("RDE", arg_kind2) ? arg_kind2 : arg_kind1;
+    }
+
+    void findDefinitions(const ASTReader::Program& arg_prog, std::vector<char>& arg_isDefined) {
+        for (const auto& def : arg_prog.defs) {
+            if (arg_isDefined.size() <= (size_t) def.func) {
+                arg_isDefined.resize(def.func + 1, false);
+            }
+            arg_isDefined[def.func] = true;
+            findDefinitions(*def.body, arg_isDefined);
+        }
+    }
+}
+
+ASTReader::Optimizer::Optimizer(Evaluator& arg_eval, std::vector<Program>& arg_progs, const std::vector<char>& arg_isDefined)
+: _eval(arg_eval), _isDefined(arg_isDefined), _progs(arg_progs), _epoch(0), _removed(arg_progs.size()) {
+}
+
+char ASTReader::Optimizer::_effect(const int32_t& arg_func, const size_t& arg_argNum) const {
+    if (arg_func < 0 || (size_t) arg_func >= _eval._funcTable.size() || ((size_t) arg_func < _isDefined.size() && _isDefined[arg_func])) {
+        return 'A';
+    }
+    const Function& func = _eval._funcTable[arg_func];
+    return func.builtin && func.accepts(arg_argNum) ? func.effect : 'A';
+}
+
+size_t ASTReader::Optimizer::_value(const std::vector<int64_t>& arg_key, const bool& arg_isConst, const double& arg_num) {
+    auto it_index = _index.find(arg_key);
+    if (it_index != _index.end()) {
+        return it_index->second;
+    }
+    _values.push_back(_Value{arg_isConst, arg_num, 0, 0, 0, false});
+    return _index[arg_key] = _values.size() - 1;
+}
+
+size_t ASTReader::Optimizer::_const(const double& arg_num) {
+    int64_t bits;
+    std::memcpy(&bits, &arg_num, sizeof (bits));
+    return _value({0, bits}, true, arg_num);
+}
+
+void ASTReader::Optimizer::_remove(const size_t& arg_prog, const std::vector<size_t>& arg_tree, const size_t& arg_keep) {
+    for (const auto& pc : arg_tree) {
+        if (pc == arg_keep) {
+            continue;
+        }
+        _removed[arg_prog][pc] = true;
+        const _Site site{arg_prog, pc};
+        auto it_site = _sites.find(site);
+        if (it_site != _sites.end()) {
+            _values[it_site->second].hasSite = false;
+            _sites.erase(it_site);
+        }
+        _uses.erase(site);
+        _notes.erase(site);
+    }
+}
+
+void ASTReader::Optimizer::_scan(const size_t& arg_prog) {
+    Program& prog = _progs[arg_prog];
+    const size_t codeSize = prog.code.size();
+    _removed[arg_prog].assign(codeSize, false);
+    const std::vector<char> isTarget = findTargets(prog);
+
+    // What each register holds: its value if known, the instructions that
+    // compute it and nothing else, and its text.
+    struct Reg {
+        int64_t val = -1;
+        std::vector<size_t> tree;
+        Text text;
+    };
+    std::vector<Reg> regs(prog.nRegs);
+    size_t condEnd = 0;
+
+    for (size_t pc = 0; pc < codeSize; pc++) {
+        if (isTarget[pc]) {
+            for (auto& reg : regs) {
+                reg.val = -1;
+            }
+        }
+        Instruction& inst = prog.code[pc];
+        std::vector<int64_t> key{2, (int64_t) inst.op};
+        std::string funcName;
+        switch (inst.op) {
+            case OpCode::LoadNum:
+            {
+                const double num = prog.numbers[inst.a];
+                regs[inst.dst] = Reg{(int64_t) _const(num), {pc}, numberText(num)};
+                continue;
+            }
+            case OpCode::LoadVar:
+            {
+                Reg& reg = regs[inst.dst];
+                reg = Reg{-1, {pc}, Text{_eval._vars.name(inst.a)}};
+                const bool isSet = (size_t) inst.a < _eval._isSet.size() && _eval._isSet[inst.a];
+                const int32_t func = _eval._funcs.find(reg.text.str);
+                if (!isSet && func >= 0) {
+                    // Read through a function without arguments.
+                    if (_effect(func, 0) == 'A') {
+                        _epoch++;
+                    }
+                    continue;
+                }
+                if (_versions.size() <= (size_t) inst.a) {
+                    _versions.resize(inst.a + 1, 0);
+                }
+                reg.val = _value({1, inst.a, _versions[inst.a], _epoch});
+                continue;
+            }
+            case OpCode::StoreVar:
+                if (_versions.size() <= (size_t) inst.a) {
+                    _versions.resize(inst.a + 1, 0);
+                }
+                _versions[inst.a]++;
+                // The register is read here as well, so its instructions stay.
+                regs[inst.dst].tree.clear();
+                continue;
+            case OpCode::Move:
+                regs[inst.a].tree.clear();
+                regs[inst.dst] = Reg();
+                continue;
+            case OpCode::Define:
+                _epoch++;
+                regs[inst.dst] = Reg();
+                continue;
+            case OpCode::Jump:
+            case OpCode::JumpIfFalse:
+            case OpCode::JumpIfTrue:
+                condEnd = std::max<size_t>(condEnd, inst.dst);
+                if (inst.op != OpCode::Jump) {
+                    regs[inst.a].tree.clear();
+                }
+                continue;
+            case OpCode::PowInt:
+                key.emplace_back(inst.b);
+                break;
+            case OpCode::Call:
+            {
+                const CallSite& site = prog.calls[inst.b];
+                const char effect = _effect(site.func, site.argNum);
+                if (effect != 'P') {
+                    for (size_t i = 0; i < site.argNum; i++) {
+                        regs[inst.a + i].tree.clear();
+                    }
+                    if (effect == 'A') {
+                        _epoch++;
+                    }
+                    regs[inst.dst] = Reg();
+                    continue;
+                }
+                key.emplace_back(site.func);
+                funcName = _eval._funcs.name(site.func);
+                break;
+            }
+            default:
+                break;
+        }
+
+        const std::vector<int32_t> operands = findOperands(prog, inst);
+        std::vector<const Text*> texts;
+        for (const auto& reg : operands) {
+            texts.emplace_back(&regs[reg].text);
+        }
+        Reg result;
+        result.text = describe(inst, texts, funcName);
+
+        bool isKnown = true, isConst = true;
+        std::vector<double> nums;
+        for (const auto& reg : operands) {
+            const int64_t val = regs[reg].val;
+            isKnown = isKnown && val >= 0;
+            if (!isKnown) {
+                break;
+            }
+            isConst = isConst && _values[val].isConst;
+            nums.emplace_back(_values[val].num);
+            key.emplace_back(val);
+            result.tree.insert(result.tree.end(), regs[reg].tree.begin(), regs[reg].tree.end());
+        }
+        if (!isKnown) {
+            regs[inst.dst] = Reg();
+            continue;
+        }
+        result.tree.emplace_back(pc);
+
+        if (isConst) {
+            // The same operations as Evaluator::execute.
+            double num = 0.;
+            switch (inst.op) {
+                case OpCode::Neg: num = -nums[0];
+                    break;
+                case OpCode::Truth: num = nums[0] >= 0.5;
+                    break;
+                case OpCode::PowInt: num = NTools::powInt(nums[0], inst.b);
+                    break;
+                case OpCode::Pow: num = pow(nums[0], nums[1]);
+                    break;
+                case OpCode::Mul: num = nums[0] * nums[1];
+                    break;
+                case OpCode::Div: num = nums[0] / nums[1];
+                    break;
+                case OpCode::Add: num = nums[0] + nums[1];
+                    break;
+                case OpCode::Less: num = nums[0] < nums[1];
+                    break;
+                case OpCode::LessEq: num = nums[0] <= nums[1];
+                    break;
+                case OpCode::Greater: num = nums[0] > nums[1];
+                    break;
+                case OpCode::GreaterEq: num = nums[0] >= nums[1];
+                    break;
+                case OpCode::Equal: num = nums[0] == nums[1];
+                    break;
+                case OpCode::NotEqual: num = nums[0] != nums[1];
+                    break;
+                case OpCode::Call:
+                    try {
+                        num = _eval._funcTable[prog.calls[inst.b].func].builtin(ArgSpan(nums.data(), nums.size()));
+                    } catch (...) {
+                        // Left to fail at run time.
+                        regs[inst.dst] = Reg();
+                        continue;
+                    }
+                    break;
+                default:
+                    break;
+            }
+            _remove(arg_prog, result.tree, pc);
+            // A negative number in the script is not worth a note.
+            if (!(inst.op == OpCode::Neg && regs[inst.a].text.isNumber)) {
+                _notes[_Site{arg_prog, pc}] = std::make_pair('F', result.text.str + " = " + format(num));
+            }
+            prog.numbers.emplace_back(num);
+            inst = Instruction{OpCode::LoadNum, inst.dst, (int32_t) prog.numbers.size() - 1, 0};
+            result.val = _const(num);
+            result.tree = {pc};
+            regs[inst.dst] = std::move(result);
+            continue;
+        }
+
+        const size_t val = _value(key);
+        result.val = val;
+        _Value& value = _values[val];
+        if (value.hasSite) {
+            _remove(arg_prog, result.tree, pc);
+            _uses[_Site{arg_prog, pc}] = val;
+            _notes[_Site{arg_prog, pc}] = std::make_pair('S', result.text.str + " from line " + std::to_string(_progs[value.prog].line));
+            inst = Instruction{OpCode::LoadVar, inst.dst, -1, 0};
+            result.tree = {pc};
+        } else if (pc >= condEnd) {
+            value.hasSite = true;
+            value.prog = arg_prog;
+            value.pc = pc;
+            value.reg = inst.dst;
+            _sites[_Site{arg_prog, pc}] = val;
+        }
+        regs[inst.dst] = std::move(result);
+    }
+}
+
+void ASTReader::Optimizer::_rewrite(const size_t& arg_prog, const std::vector<int32_t>& arg_hidden) {
+    Program& prog = _progs[arg_prog];
+    std::vector<Instruction> code;
+    std::vector<int32_t> newPc(prog.code.size() + 1);
+    for (size_t pc = 0; pc < prog.code.size(); pc++) {
+        newPc[pc] = code.size();
+        if (_removed[arg_prog][pc]) {
+            continue;
+        }
+        const _Site site{arg_prog, pc};
+        code.emplace_back(prog.code[pc]);
+        auto it_use = _uses.find(site);
+        if (it_use != _uses.end()) {
+            code.back().a = arg_hidden[it_use->second];
+        }
+        auto it_site = _sites.find(site);
+        if (it_site != _sites.end() && arg_hidden[it_site->second] >= 0) {
+            code.emplace_back(Instruction{OpCode::StoreVar, prog.code[pc].dst, arg_hidden[it_site->second], 0});
+        }
+    }
+    newPc[prog.code.size()] = code.size();
+    for (auto& inst : code) {
+        if (isJump(inst.op)) {
+            inst.dst = newPc[inst.dst];
+        }
+    }
+    prog.code = std::move(code);
+}
+
+void ASTReader::Optimizer::_classify(const std::vector<Program>& arg_progs, const char& arg_kind) {
+    bool isAny = false;
+    for (const auto& prog : arg_progs) {
+        for (const auto& inst : prog.code) {
+            if (inst.op == OpCode::StoreVar) {
+                _kinds[inst.a] = later(_kinds[inst.a], arg_kind);
+            } else if (inst.op == OpCode::Define) {
+                isAny = true;
+            } else if (inst.op == OpCode::Call) {
+                isAny = isAny || _effect(prog.calls[inst.b].func, prog.calls[inst.b].argNum) == 'A';
+            } else if (inst.op == OpCode::LoadVar && _kinds[inst.a] == 'E') {
+                // An unset variable may be read through a function.
+                const int32_t func = _eval._funcs.find(_eval._vars.name(inst.a));
+                isAny = isAny || (func >= 0 && _effect(func, 0) == 'A');
+            }
+        }
+    }
+    if (isAny) {
+        for (auto& kind : _kinds) {
+            kind = later(kind, arg_kind);
+        }
+    }
+}
+
+void ASTReader::Optimizer::_hoist(const size_t& arg_prog, std::vector<Program>& arg_hoisted) {
+    Program& prog = _progs[arg_prog];
+    const size_t codeSize = prog.code.size();
+    _removed[arg_prog].assign(codeSize, false);
+    const std::vector<char> isTarget = findTargets(prog);
+
+    // How often the value of each register may change, the instructions
+    // that compute it and nothing else, and its text.
+    struct Reg {
+        char kind = 'E';
+        std::vector<size_t> tree;
+        Text text;
+    };
+    std::vector<Reg> regs(prog.nRegs);
+    std::vector<char> isHoisted(codeSize, false);
+    std::vector<std::pair<size_t, int32_t>> roots;
+    auto use = [&](const int32_t & arg_reg) {
+        Reg& reg = regs[arg_reg];
+        // A line compiled into native code runs as it is.
+        if (!prog.native && reg.kind != 'E' && !reg.tree.empty()) {
+            const size_t root = reg.tree.back();
+            if (prog.code[root].op != OpCode::LoadNum && prog.code[root].op != OpCode::LoadVar) {
+                // A variable named after where the value is computed, which
+                // no script can refer to.
+                const int32_t hidden = _eval._vars.intern("#" + std::to_string(prog.line) + ":" + std::to_string(root));
+                for (const auto& pc : reg.tree) {
+                    isHoisted[pc] = true;
+                    _removed[arg_prog][pc] = pc != root;
+                }
+                roots.emplace_back(root, hidden);
+                _report.notes.emplace_back(prog.line, reg.text.str + (reg.kind == 'R' ? " (per run)" : " (per dataset)"));
+            }
+        }
+        reg.tree.clear();
+    };
+
+    for (size_t pc = 0; pc < codeSize; pc++) {
+        if (isTarget[pc]) {
+            // A value that may come from another path is hoisted as it is.
+            for (size_t reg = 0; reg < regs.size(); reg++) {
+                use(reg);
+                regs[reg].kind = 'E';
+            }
+        }
+        const Instruction& inst = prog.code[pc];
+        std::string funcName;
+        switch (inst.op) {
+            case OpCode::LoadNum:
+                regs[inst.dst] = Reg{'R', {pc}, numberText(prog.numbers[inst.a])};
+                continue;
+            case OpCode::LoadVar:
+                regs[inst.dst] = Reg{(size_t) inst.a < _kinds.size() ? _kinds[inst.a] : 'E', {pc}, Text{_eval._vars.name(inst.a)}};
+                continue;
+            case OpCode::StoreVar:
+                use(inst.dst);
+                continue;
+            case OpCode::Move:
+                use(inst.a);
+                regs[inst.dst] = Reg();
+                continue;
+            case OpCode::Define:
+                regs[inst.dst] = Reg();
+                continue;
+            case OpCode::Jump:
+                continue;
+            case OpCode::JumpIfFalse:
+            case OpCode::JumpIfTrue:
+                use(inst.a);
+                continue;
+            case OpCode::Call:
+            {
+                const CallSite& site = prog.calls[inst.b];
+                if (_effect(site.func, site.argNum) != 'P') {
+                    for (size_t i = 0; i < site.argNum; i++) {
+                        use(inst.a + i);
+                    }
+                    regs[inst.dst] = Reg();
+                    continue;
+                }
+                funcName = _eval._funcs.name(site.func);
+                break;
+            }
+            default:
+                break;
+        }
+
+        const std::vector<int32_t> operands = findOperands(prog, inst);
+        Reg result;
+        result.kind = 'R';
+        std::vector<const Text*> texts;
+        for (const auto& reg : operands) {
+            result.kind = later(result.kind, regs[reg].kind);
+            texts.emplace_back(&regs[reg].text);
+        }
+        if (result.kind == 'E') {
+            for (const auto& reg : operands) {
+                use(reg);
+            }
+            regs[inst.dst] = Reg();
+            continue;
+        }
+        result.text = describe(inst, texts, funcName);
+        for (const auto& reg : operands) {
+            result.tree.insert(result.tree.end(), regs[reg].tree.begin(), regs[reg].tree.end());
+        }
+        result.tree.emplace_back(pc);
+        regs[inst.dst] = std::move(result);
+    }
+    if (roots.empty()) {
+        return;
+    }
+
+    // The hoisted instructions keep their order and registers, and each
+    // value is stored right after it is computed.
+    Program hoisted;
+    hoisted.numbers = prog.numbers;
+    hoisted.calls = prog.calls;
+    hoisted.nRegs = prog.nRegs;
+    hoisted.line = prog.line;
+    std::map<size_t, int32_t> hidden(roots.begin(), roots.end());
+    for (size_t pc = 0; pc < codeSize; pc++) {
+        if (!isHoisted[pc]) {
+            continue;
+        }
+        hoisted.code.emplace_back(prog.code[pc]);
+        auto it_hidden = hidden.find(pc);
+        if (it_hidden != hidden.end()) {
+            hoisted.code.emplace_back(Instruction{OpCode::StoreVar, prog.code[pc].dst, it_hidden->second, 0});
+            prog.code[pc] = Instruction{OpCode::LoadVar, prog.code[pc].dst, it_hidden->second, 0};
+        }
+    }
+    arg_hoisted.emplace_back(std::move(hoisted));
+    _report.nHoisted += roots.size();
+    _rewrite(arg_prog, {});
+}
+
+ASTReader::Optimizer::Report ASTReader::Optimizer::optimize(Evaluator& arg_eval, std::vector<Program>& arg_progs, const size_t& arg_first, const std::vector<char>& arg_isDefined) {
+    Optimizer optimizer(arg_eval, arg_progs, arg_isDefined);
+    size_t codeSize = 0;
+    for (size_t prog = arg_first; prog < arg_progs.size(); prog++) {
+        codeSize += arg_progs[prog].code.size();
+        optimizer._scan(prog);
+    }
+
+    // A value used again is kept in a variable named after where it is
+    // computed, which no script can refer to.
+    std::vector<int32_t> hidden(optimizer._values.size(), -1);
+    for (const auto& use : optimizer._uses) {
+        const _Value& value = optimizer._values[use.second];
+        if (hidden[use.second] < 0) {
+            hidden[use.second] = arg_eval._vars.intern("#" + std::to_string(arg_progs[value.prog].line) + "." + std::to_string(value.pc));
+        }
+    }
+    for (size_t prog = arg_first; prog < arg_progs.size(); prog++) {
+        optimizer._rewrite(prog, hidden);
+        codeSize -= arg_progs[prog].code.size();
+    }
+
+    Report& report = optimizer._report;
+    report.nRemoved = codeSize;
+    report.nShared = optimizer._uses.size();
+    for (const auto& note : optimizer._notes) {
+        report.nFolded += note.second.first == 'F';
+        report.notes.emplace_back(arg_progs[note.first.prog].line, note.second.second);
+    }
+    return report;
+}
+
+ASTReader::Optimizer::Report ASTReader::Optimizer::hoist(Evaluator& arg_eval, std::vector<Program>& arg_main, std::vector<Program>& arg_hoisted, const std::vector<const std::vector<Program>*>& arg_routines,
+        const std::vector<int32_t>& arg_datasetSlots, const std::vector<int32_t>& arg_recordSlots, const std::vector<char>& arg_isDefined) {
+    Optimizer optimizer(arg_eval, arg_main, arg_isDefined);
+    std::vector<char>& kinds = optimizer._kinds;
+    kinds.assign(arg_eval._vars.size(), 'E');
+    for (size_t slot = 0; slot < kinds.size() && slot < arg_eval._isSet.size(); slot++) {
+        kinds[slot] = arg_eval._isSet[slot] ? 'R' : 'E';
+    }
+    for (const auto& slot : arg_datasetSlots) {
+        kinds.at(slot) = later(kinds.at(slot), 'D');
+    }
+    for (const auto& progs : arg_routines) {
+        optimizer._classify(*progs, 'D');
+    }
+    for (const auto& slot : arg_recordSlots) {
+        kinds.at(slot) = 'E';
+    }
+    optimizer._classify(arg_main, 'E');
+
+    arg_hoisted.clear();
+    for (size_t prog = 0; prog < arg_main.size(); prog++) {
+        optimizer._hoist(prog, arg_hoisted);
+    }
+    return optimizer._report;
+}
+
+char ASTReader::Optimizer::_callKind(const int32_t& arg_func, const size_t& arg_argNum) const {
+    if (arg_func < 0 || (size_t) arg_func >= _eval._funcTable.size() || ((size_t) arg_func < _isDefined.size() && _isDefined[arg_func])) {
+        return 'A';
+    }
+    const Function& func = _eval._funcTable[arg_func];
+    if (!func.accepts(arg_argNum)) {
+        return 'A';
+    }
+    if (func.builtin) {
+        return func.effect != 'A' || !func.writes.empty() ? 'B' : 'A';
+    }
+    return func.body ? 'U' : 'A';
+}
+
+bool ASTReader::Optimizer::_findAssigned(const Program& arg_prog, std::vector<char>& arg_isAssigned, std::vector<int32_t>& arg_calling) const {
+    for (const auto& inst : arg_prog.code) {
+        int32_t func = -1;
+        size_t argNum = 0;
+        if (inst.op == OpCode::StoreVar) {
+            arg_isAssigned.at(inst.a) = true;
+        } else if (inst.op == OpCode::Define) {
+            return false;
+        } else if (inst.op == OpCode::Call) {
+            func = arg_prog.calls[inst.b].func;
+            argNum = arg_prog.calls[inst.b].argNum;
+        } else if (inst.op == OpCode::LoadVar && !((size_t) inst.a < _eval._isSet.size() && _eval._isSet[inst.a])) {
+            // An unset variable may be read through a function.
+            func = _eval._funcs.find(_eval._vars.name(inst.a));
+        }
+        if (func < 0) {
+            continue;
+        }
+        const char kind = _callKind(func, argNum);
+        if (kind == 'A' || std::find(arg_calling.begin(), arg_calling.end(), func) != arg_calling.end()) {
+            return false;
+        }
+        const Function& callee = _eval._funcTable[func];
+        if (kind == 'B') {
+            for (const auto& slot : callee.writes) {
+                arg_isAssigned.at(slot) = true;
+            }
+            continue;
+        }
+        arg_calling.emplace_back(func);
+        if (!_findAssigned(*callee.body, arg_isAssigned, arg_calling)) {
+            return false;
+        }
+        arg_calling.pop_back();
+    }
+    return true;
+}
+
+bool ASTReader::Optimizer::_readsEarly(const Program& arg_prog, const std::vector<char>& arg_isAssigned, std::vector<char>& arg_isStored, std::vector<int32_t>& arg_calling) const {
+    // The variables stored on every path to each jump target, where the
+    // paths meet. Jumps only go forward.
+    std::map<size_t, std::vector<char>> atTargets;
+    auto meet = [](std::vector<char>& arg_into, const std::vector<char>& arg_from) {
+        for (size_t slot = 0; slot < arg_into.size(); slot++) {
+            arg_into[slot] = arg_into[slot] && arg_from[slot];
+        }
+    };
+    bool isLive = true;
+    for (size_t pc = 0; pc <= arg_prog.code.size(); pc++) {
+        auto it_target = atTargets.find(pc);
+        if (it_target != atTargets.end()) {
+            if (isLive) {
+                meet(arg_isStored, it_target->second);
+            } else {
+                arg_isStored = std::move(it_target->second);
+            }
+            isLive = true;
+            atTargets.erase(it_target);
+        }
+        if (pc == arg_prog.code.size()) {
+            break;
+        }
+        if (!isLive) {
+            continue;
+        }
+        const Instruction& inst = arg_prog.code[pc];
+        int32_t func = -1;
+        size_t argNum = 0;
+        switch (inst.op) {
+            case OpCode::LoadVar:
+                if (arg_isAssigned[inst.a] && !arg_isStored[inst.a]) {
+                    return true;
+                }
+                if (!arg_isAssigned[inst.a] && !((size_t) inst.a < _eval._isSet.size() && _eval._isSet[inst.a])) {
+                    func = _eval._funcs.find(_eval._vars.name(inst.a));
+                }
+                break;
+            case OpCode::StoreVar:
+                arg_isStored[inst.a] = true;
+                break;
+            case OpCode::Define:
+                return true;
+            case OpCode::Call:
+                func = arg_prog.calls[inst.b].func;
+                argNum = arg_prog.calls[inst.b].argNum;
+                break;
+            case OpCode::Jump:
+            case OpCode::JumpIfFalse:
+            case OpCode::JumpIfTrue:
+            {
+                if ((size_t) inst.dst <= pc) {
+                    return true;
+                }
+                auto it_into = atTargets.find(inst.dst);
+                if (it_into == atTargets.end()) {
+                    atTargets.emplace(inst.dst, arg_isStored);
+                } else {
+                    meet(it_into->second, arg_isStored);
+                }
+                isLive = inst.op != OpCode::Jump;
+                break;
+            }
+            default:
+                break;
+        }
+        if (func < 0) {
+            continue;
+        }
+        const char kind = _callKind(func, argNum);
+        if (kind == 'A' || std::find(arg_calling.begin(), arg_calling.end(), func) != arg_calling.end()) {
+            return true;
+        }
+        const Function& callee = _eval._funcTable[func];
+        if (kind == 'B') {
+            for (const auto& slot : callee.reads) {
+                if (arg_isAssigned.at(slot) && !arg_isStored.at(slot)) {
+                    return true;
+                }
+            }
+            continue;
+        }
+        arg_calling.emplace_back(func);
+        if (_readsEarly(*callee.body, arg_isAssigned, arg_isStored, arg_calling)) {
+            return true;
+        }
+        arg_calling.pop_back();
+    }
+    return false;
+}
+
+bool ASTReader::Optimizer::carriesState(Evaluator& arg_eval, const std::vector<Program>& arg_begin, const std::vector<Program>& arg_main, const std::vector<Program>& arg_end,
+        const std::vector<int32_t>& arg_datasetSlots, const std::vector<int32_t>& arg_recordSlots, const std::vector<char>& arg_isDefined, std::vector<int32_t>& arg_assigned) {
+    std::vector<Program> none;
+    const Optimizer optimizer(arg_eval, none, arg_isDefined);
+    std::vector<char> isAssigned(arg_eval._vars.size(), false);
+    std::vector<int32_t> calling;
+    for (const auto& slots : {&arg_datasetSlots, &arg_recordSlots}) {
+        for (const auto& slot : *slots) {
+            isAssigned.at(slot) = true;
+        }
+    }
+    for (const auto& progs : {&arg_begin, &arg_main, &arg_end}) {
+        for (const auto& prog : *progs) {
+            if (!optimizer._findAssigned(prog, isAssigned, calling)) {
+                return true;
+            }
+        }
+    }
+
+    std::vector<char> isStored(isAssigned.size(), false);
+    for (const auto& slot : arg_datasetSlots) {
+        isStored[slot] = true;
+    }
+    for (const auto& prog : arg_begin) {
+        if (optimizer._readsEarly(prog, isAssigned, isStored, calling)) {
+            return true;
+        }
+    }
+    // A record starts from the end of [BEGIN_ROUTINE], and so does
+    // [END_ROUTINE] when there are no records.
+    std::vector<char> isStoredMain = isStored;
+    for (const auto& slot : arg_recordSlots) {
+        isStoredMain[slot] = true;
+    }
+    for (const auto& prog : arg_main) {
+        if (optimizer._readsEarly(prog, isAssigned, isStoredMain, calling)) {
+            return true;
+        }
+    }
+    for (const auto& prog : arg_end) {
+        if (optimizer._readsEarly(prog, isAssigned, isStored, calling)) {
+            return true;
+        }
+    }
+
+    arg_assigned.clear();
+    for (size_t slot = 0; slot < isAssigned.size(); slot++) {
+        if (isAssigned[slot]) {
+            arg_assigned.emplace_back(slot);
+        }
+    }
+    return false;
+}
+
+void ASTReader::Optimizer::findDefinitions(const std::vector<Program>& arg_progs, std::vector<char>& arg_isDefined) {
+    for (const auto& prog : arg_progs) {
+        ::findDefinitions(prog, arg_isDefined);
+    }
+}
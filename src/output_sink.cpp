@@ -0,0 +1,120 @@
+/**
+ * @file output_sink.cpp
+ * @brief Formats of what print writes
+ * @date Created on: 2026/10/17, 23:10
+ */
+
+#include "include/output_sink.h"
+#include "include/rg_data.h"
+#include <cstdio>
+#include <locale>
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+namespace {
+
+    /**
+     * Appends arg_val as printf would format it with "%.*" and arg_format,
+     * which is 'e', 'f' or 'g'. This is also how the stream formats it.
+     */
+    void appendNumber(std::string& arg_buf, const double& arg_val, const char& arg_format, const int& arg_precision) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        char buf[128];
+        const std::chars_format fmt = arg_format == 'e' ? std::chars_format::scientific
+                : arg_format == 'f' ? std::chars_format::fixed : std::chars_format::general;
+        std::to_chars_result result = std::to_chars(buf, buf + sizeof (buf), arg_val, fmt, arg_precision);
+        if (result.ec == std::errc()) {
+            arg_buf.append(buf, result.ptr);
+            return;
+        }
+#endif
+        const char format[] = {'%', '.', '*', arg_format, '\0'};
+        const int size = std::snprintf(nullptr, 0, format, arg_precision, arg_val);
+        const size_t pos = arg_buf.size();
+        arg_buf.resize(pos + size + 1);
+        std::snprintf(&arg_buf[pos], size + 1, format, arg_precision, arg_val);
+        arg_buf.resize(pos + size);
+    }
+
+    /**
+     * Appends the shortest form of arg_val that reads back to it.
+     */
+    void appendShortest(std::string& arg_buf, const double& arg_val) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        char buf[32];
+        std::to_chars_result result = std::to_chars(buf, buf + sizeof (buf), arg_val);
+        if (result.ec == std::errc()) {
+            arg_buf.append(buf, result.ptr);
+            return;
+        }
+#endif
+        appendNumber(arg_buf, arg_val, 'g', 17);
+    }
+}
+
+std::unique_ptr<OutputSink> OutputSink::create(const std::string& arg_format, std::ostream& arg_os) {
+    if (arg_format == "text") {
+        return std::unique_ptr<OutputSink>(new TextSink(arg_os));
+    } else if (arg_format == "csv") {
+        return std::unique_ptr<OutputSink>(new CsvSink(arg_os));
+    } else if (arg_format == "binary") {
+        if (!RGData::isLittleEndian()) {
+            throw OutputSinkError("OutputSink: Big-endian hosts are not supported.");
+        }
+        return std::unique_ptr<OutputSink>(new BinarySink(arg_os));
+    }
+    throw OutputSinkError("OutputSink: Unknown format \"" + arg_format + "\".");
+}
+
+void TextSink::row(const ASTReader::ArgSpan& arg_vals, const std::string& arg_delim) {
+    const std::ios::fmtflags flags = _os.flags();
+    const std::ios::fmtflags floatfield = flags & std::ios::floatfield;
+    if ((flags & (std::ios::showpos | std::ios::showpoint | std::ios::uppercase)) || _os.width() != 0
+            || floatfield == (std::ios::fixed | std::ios::scientific) || _os.getloc() != std::locale::classic()) {
+        for (size_t i = 0; i < arg_vals.size(); i++) {
+            _os << (i ? arg_delim : "") << arg_vals[i];
+        }
+        _os << '\n';
+        return;
+    }
+    const char format = floatfield == std::ios::scientific ? 'e' : floatfield == std::ios::fixed ? 'f' : 'g';
+    // A negative precision means the default, as in printf.
+    const int precision = _os.precision() < 0 ? 6 : int(_os.precision());
+    _buf.clear();
+    for (size_t i = 0; i < arg_vals.size(); i++) {
+        if (i) {
+            _buf += arg_delim;
+        }
+        appendNumber(_buf, arg_vals[i], format, precision);
+    }
+    _buf += '\n';
+    _os.write(_buf.data(), _buf.size());
+}
+
+void TextSink::text(const std::string& arg_text) {
+    _os << arg_text << '\n';
+}
+
+void CsvSink::row(const ASTReader::ArgSpan& arg_vals, const std::string&) {
+    _buf.clear();
+    for (size_t i = 0; i < arg_vals.size(); i++) {
+        if (i) {
+            _buf += ',';
+        }
+        appendShortest(_buf, arg_vals[i]);
+    }
+    _buf += '\n';
+    _os.write(_buf.data(), _buf.size());
+}
+
+void CsvSink::text(const std::string& arg_text) {
+    _os << arg_text << '\n';
+}
+
+void BinarySink::row(const ASTReader::ArgSpan& arg_vals, const std::string&) {
+    const uint32_t size = arg_vals.size();
+    _buf.assign(reinterpret_cast<const char*> (&size), sizeof (size));
+    _buf.append(reinterpret_cast<const char*> (arg_vals.begin()), sizeof (double) * size);
+    _os.write(_buf.data(), _buf.size());
+}
@@ -0,0 +1,88 @@
+/**
+ * @file profiler.cpp
+ * @brief Wall-time profiler for script lines, builtins and parsing
+ * @date Created on: 2026/10/17, 20:10
+ */
+
+#include "include/profiler.h"
+#include <iomanip>
+#include <sstream>
+
+void Profiler::merge(const Profiler& arg_other) {
+    auto add = [](Stat& arg_stat, const Stat& arg_add) {
+        arg_stat.ticks += arg_add.ticks;
+        arg_stat.count += arg_add.count;
+    };
+    for (size_t i = 0; i < arg_other._lines.size(); i++) {
+        add(*line(i), arg_other._lines[i]);
+    }
+    for (size_t i = 0; i < arg_other._funcs.size(); i++) {
+        add(*func(i), arg_other._funcs[i]);
+    }
+    add(_records, arg_other._records);
+    add(_datasets, arg_other._datasets);
+}
+
+void Profiler::report(std::ostream& arg_os, const std::vector<std::string>& arg_funcNames) const {
+    const double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - _startTime).count();
+    const uint64_t wallTicks = now() - _startTicks;
+    const double secPerTick = wallTicks > 0 ? wallTime / wallTicks : 0.;
+
+    std::ostringstream os;
+    os << std::fixed;
+    auto row = [&os, wallTime, secPerTick](const std::string& arg_label, const Stat& arg_stat) {
+        const double time = arg_stat.ticks * secPerTick;
+        os << std::left << std::setw(46) << arg_label.substr(0, 45) << std::right
+                << std::setw(12) << std::setprecision(6) << time
+                << std::setw(14) << arg_stat.count
+                << std::setw(9) << std::setprecision(2) << (wallTime > 0 ? 100. * time / wallTime : 0.) << "%" << std::endl;
+    };
+
+    os << "Profile (wall time " << std::setprecision(6) << wallTime << " s)" << std::endl;
+    os << std::left << std::setw(46) << "section / line" << std::right
+            << std::setw(12) << "time [s]" << std::setw(14) << "calls" << std::setw(10) << "share" << std::endl;
+
+    const std::vector<std::pair<char, std::string>> sections = {
+        {'I', "[INITIALIZE]"},
+        {'B', "[BEGIN_ROUTINE]"},
+        {'M', "[MAIN_ROUTINE]"},
+        {'E', "[END_ROUTINE]"},
+        {'F', "[FINALIZE]"}
+    };
+    for (const auto& sec : sections) {
+        Stat total;
+        bool isFirst = true;
+        std::ostringstream lines;
+        for (size_t i = 0; i < _sources.size() && i < _lines.size(); i++) {
+            if (_sources[i].first != sec.first) {
+                continue;
+            }
+            total.ticks += _lines[i].ticks;
+            if (isFirst) {
+                total.count = _lines[i].count;
+                isFirst = false;
+            }
+        }
+        if (isFirst) {
+            continue;
+        }
+        row(sec.second, total);
+        for (size_t i = 0; i < _sources.size() && i < _lines.size(); i++) {
+            if (_sources[i].first == sec.first) {
+                row("  " + std::to_string(i) + ": " + _sources[i].second, _lines[i]);
+            }
+        }
+    }
+
+    os << "[DATASET] parsing" << std::endl;
+    row("  dataset values", _datasets);
+    row("  records", _records);
+
+    os << "builtins" << std::endl;
+    for (size_t i = 0; i < _funcs.size() && i < arg_funcNames.size(); i++) {
+        if (_funcs[i].count > 0) {
+            row("  " + arg_funcNames[i], _funcs[i]);
+        }
+    }
+    arg_os << os.str();
+}
@@ -0,0 +1,218 @@
+/**
+ * @file rg_data.cpp
+ * @brief Binary columnar container of RG data
+ * @date Created on: 2026/10/17, 17:05
+ */
+
+#include "include/rg_data.h"
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const char RGData::magic[8] = {'E', 'L', 'V', 'A', 'S', 'R', 'G', 'D'};
+const uint32_t RGData::version;
+const size_t RGData::headerSize;
+
+RGData::RGData(const std::string& arg_path) : _base(nullptr), _size(0), _table(nullptr), _nDatasets(0) {
+    if (!isLittleEndian()) {
+        throw RGDataError("RGData: Big-endian hosts are not supported.");
+    }
+#ifdef _WIN32
+    std::ifstream ifs(arg_path, std::ios::binary | std::ios::ate);
+    if (!ifs) {
+        throw RGDataError("File open error. (" + arg_path + ")");
+    }
+    _size = ifs.tellg();
+    _buffer.resize((_size + 7) / 8);
+    ifs.seekg(0);
+    ifs.read(reinterpret_cast<char*> (_buffer.data()), _size);
+    _base = reinterpret_cast<const char*> (_buffer.data());
+#else
+    int fd = open(arg_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw RGDataError("File open error. (" + arg_path + ")");
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw RGDataError("File open error. (" + arg_path + ")");
+    }
+    _size = st.st_size;
+    if (_size > 0) {
+        void* addr = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            close(fd);
+            throw RGDataError("RGData: mmap failed. (" + arg_path + ")");
+        }
+        _base = static_cast<const char*> (addr);
+    }
+    close(fd);
+#endif
+    try {
+        _parse(arg_path);
+    } catch (...) {
+#ifndef _WIN32
+        if (_base) {
+            munmap(const_cast<char*> (_base), _size);
+        }
+#endif
+        throw;
+    }
+}
+
+RGData::~RGData() {
+#ifndef _WIN32
+    if (_base) {
+        munmap(const_cast<char*> (_base), _size);
+    }
+#endif
+}
+
+void RGData::_parse(const std::string& arg_path) {
+    if (_size < headerSize || memcmp(_base, magic, sizeof (magic)) != 0) {
+        throw RGDataError("RGData: Not an RG data file. (" + arg_path + ")");
+    }
+    uint32_t header[4];
+    uint64_t counts[2];
+    memcpy(header, _base + 8, sizeof (header));
+    memcpy(counts, _base + 24, sizeof (counts));
+    if (header[0] != version) {
+        throw RGDataError("RGData: Unsupported format version. (" + arg_path + ")");
+    }
+    _nDatasets = counts[0];
+    uint64_t pos = counts[1];
+
+    auto readName = [ this, &pos, &arg_path ]() {
+        uint32_t length;
+        if (pos + sizeof (length) > _size) {
+            throw RGDataError("RGData: Broken file. (" + arg_path + ")");
+        }
+        memcpy(&length, _base + pos, sizeof (length));
+        pos += sizeof (length);
+        if (pos + length > _size) {
+            throw RGDataError("RGData: Broken file. (" + arg_path + ")");
+        }
+        std::string name(_base + pos, length);
+        pos += length;
+        return name;
+    };
+    for (uint32_t i = 0; i < header[1]; i++) {
+        _datasetVarNames.emplace_back(readName());
+    }
+    for (uint32_t i = 0; i < header[2]; i++) {
+        _recordVarNames.emplace_back(readName());
+    }
+    pos = (pos + 7) & ~uint64_t(7);
+
+    uint64_t entrySize = 24 + 8 * _datasetVarNames.size();
+    if (pos > _size || (_size - pos) / entrySize < _nDatasets) {
+        throw RGDataError("RGData: Broken file. (" + arg_path + ")");
+    }
+    _table = _base + pos;
+    for (size_t i = 0; i < _nDatasets; i++) {
+        const uint64_t* entry = _entry(i);
+        if (entry[0] % 8 != 0 || entry[0] < headerSize || entry[0] > _size || entry[2] > _datasetVarNames.size()
+                || (_recordVarNames.size() != 0 && (_size - entry[0]) / (8 * _recordVarNames.size()) < entry[1])) {
+            throw RGDataError("RGData: Broken file. (" + arg_path + ")");
+        }
+    }
+}
+
+bool RGData::isRGData(const std::string& arg_path) {
+    std::ifstream ifs(arg_path, std::ios::binary);
+    char buf[sizeof (magic)];
+    return ifs.read(buf, sizeof (buf)) && memcmp(buf, magic, sizeof (magic)) == 0;
+}
+
+RGDataWriter::RGDataWriter(const std::string& arg_path) : _ofs(arg_path, std::ios::binary), _nRecordVars(0), _isOpen(false) {
+    if (!RGData::isLittleEndian()) {
+        throw RGData::RGDataError("RGDataWriter: Big-endian hosts are not supported.");
+    }
+    if (!_ofs) {
+        throw RGData::RGDataError("File open error. (" + arg_path + ")");
+    }
+    _ofs.write(std::string(RGData::headerSize, '\0').data(), RGData::headerSize);
+}
+
+void RGDataWriter::_pad() {
+    while (_ofs.tellp() % 8 != 0) {
+        _ofs.put('\0');
+    }
+}
+
+void RGDataWriter::beginDataset(const std::vector<double>& arg_datasetVals) {
+    endDataset();
+    _datasetVals.emplace_back(arg_datasetVals);
+    _rows.clear();
+    _isOpen = true;
+}
+
+void RGDataWriter::addRecord(const std::vector<double>& arg_recordVals) {
+    if (_nRecordVars == 0) {
+        _nRecordVars = arg_recordVals.size();
+    } else if (_nRecordVars != arg_recordVals.size()) {
+        throw RGData::RGDataError("RGDataWriter: Inconsistent number of record variables.");
+    }
+    _rows.insert(_rows.end(), arg_recordVals.begin(), arg_recordVals.end());
+}
+
+void RGDataWriter::endDataset() {
+    if (!_isOpen) {
+        return;
+    }
+    size_t nRecords = _nRecordVars == 0 ? 0 : _rows.size() / _nRecordVars;
+    _offsets.emplace_back(_ofs.tellp());
+    _nRecords.emplace_back(nRecords);
+    for (size_t var = 0; var < _nRecordVars; var++) {
+        for (size_t rec = 0; rec < nRecords; rec++) {
+            _write(_rows[rec * _nRecordVars + var]);
+        }
+    }
+    _rows.clear();
+    _isOpen = false;
+}
+
+void RGDataWriter::close(const std::vector<std::string>& arg_datasetVarNames, const std::vector<std::string>& arg_recordVarNames) {
+    endDataset();
+    if (_nRecordVars != 0 && _nRecordVars != arg_recordVarNames.size()) {
+        throw RGData::RGDataError("RGDataWriter: Inconsistent number of record variables.");
+    }
+    uint64_t trailer = _ofs.tellp();
+    for (const auto& names : {arg_datasetVarNames, arg_recordVarNames}) {
+        for (const auto& name : names) {
+            _write(uint32_t(name.size()));
+            _ofs.write(name.data(), name.size());
+        }
+    }
+    _pad();
+    for (size_t i = 0; i < _offsets.size(); i++) {
+        if (_datasetVals[i].size() > arg_datasetVarNames.size()) {
+            throw RGData::RGDataError("RGDataWriter: Inconsistent number of dataset variables.");
+        }
+        _write(_offsets[i]);
+        _write(_nRecords[i]);
+        _write(uint64_t(_datasetVals[i].size()));
+        std::vector<double> vals(_datasetVals[i]);
+        vals.resize(arg_datasetVarNames.size(), 0.);
+        for (const auto& val : vals) {
+            _write(val);
+        }
+    }
+    _ofs.seekp(0);
+    _ofs.write(RGData::magic, sizeof (RGData::magic));
+    _write(RGData::version);
+    _write(uint32_t(arg_datasetVarNames.size()));
+    _write(uint32_t(arg_recordVarNames.size()));
+    _write(uint32_t(0));
+    _write(uint64_t(_offsets.size()));
+    _write(trailer);
+    _ofs.close();
+    if (!_ofs) {
+        throw RGData::RGDataError("RGDataWriter: Write error.");
+    }
+}
@@ -0,0 +1,101 @@
+/**
+ * @file rge_solver.cpp
+ * @brief Adaptive integrator of renormalization group equations
+ * @date Created on: 2026/10/17, 23:40
+ */
+
+#include "include/rge_solver.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Dormand-Prince 5(4) tableau. The fifth-order weights are the last
+    // row of a, so that the slope at the new point is the first slope of
+    // the next step.
+    const double a[7][6] = {
+        {},
+        {1. / 5.},
+        {3. / 40., 9. / 40.},
+        {44. / 45., -56. / 15., 32. / 9.},
+        {19372. / 6561., -25360. / 2187., 64448. / 6561., -212. / 729.},
+        {9017. / 3168., -355. / 33., 46732. / 5247., 49. / 176., -5103. / 18656.},
+        {35. / 384., 0., 500. / 1113., 125. / 192., -2187. / 6784., 11. / 84.}
+    };
+
+    // Difference between the fifth- and the fourth-order weights.
+    const double e[7] = {71. / 57600., 0., -71. / 16695., 71. / 1920., -17253. / 339200., 22. / 525., -1. / 40.};
+}
+
+const size_t RGESolver::maxSteps;
+
+RGESolver::RGESolver(const size_t& arg_nVars, const Beta& arg_beta, const double& arg_tolerance)
+: _nVars(arg_nVars), _beta(arg_beta), _tolerance(arg_tolerance), _step(0.), _nSteps(0), _yTemp(arg_nVars), _yNew(arg_nVars), _hasSlope(false) {
+    if (!(arg_tolerance > 0.)) {
+        throw RGESolverError("RGESolver: The tolerance must be positive.");
+    }
+    for (auto& k : _k) {
+        k.resize(arg_nVars);
+    }
+}
+
+bool RGESolver::evolve(double& arg_t, double* arg_y, const double& arg_tEnd) {
+    const double dir = arg_tEnd >= arg_t ? 1. : -1.;
+    if (_step == 0.) {
+        _step = std::fabs(arg_tEnd - arg_t) / 16.;
+    }
+    // The slope of the last step is reused if arg_y is where it ended.
+    if (!_hasSlope || !std::equal(arg_y, arg_y + _nVars, _yNew.begin())) {
+        _beta(arg_y, _k[0].data());
+        _hasSlope = true;
+    }
+    size_t nSteps = 0;
+    while (arg_t != arg_tEnd) {
+        const double remaining = std::fabs(arg_tEnd - arg_t);
+        const bool isLast = _step >= remaining;
+        const double h = dir * (isLast ? remaining : _step);
+        for (int stage = 1; stage < 7; stage++) {
+            double* y = stage == 6 ? _yNew.data() : _yTemp.data();
+            for (size_t i = 0; i < _nVars; i++) {
+                double sum = 0.;
+                for (int j = 0; j < stage; j++) {
+                    sum += a[stage][j] * _k[j][i];
+                }
+                y[i] = arg_y[i] + h * sum;
+            }
+            _beta(y, _k[stage].data());
+        }
+        double err = 0.;
+        for (size_t i = 0; i < _nVars; i++) {
+            double diff = 0.;
+            for (int j = 0; j < 7; j++) {
+                diff += e[j] * _k[j][i];
+            }
+            const double scale = _tolerance * (1. + std::max(std::fabs(arg_y[i]), std::fabs(_yNew[i])));
+            err += std::pow(h * diff / scale, 2);
+        }
+        err = std::sqrt(err / _nVars);
+        if (!(err <= 1.)) {
+            // Also for a solution that is not finite, whose err is NaN.
+            _step = std::fabs(h) * (err < HUGE_VAL ? std::max(.2, .9 * std::pow(err, -.2)) : .2);
+            if (_step < 1e-12 * std::max(1., std::fabs(arg_t))) {
+                _hasSlope = false;
+                return false;
+            }
+            continue;
+        }
+        arg_t = isLast ? arg_tEnd : arg_t + h;
+        std::copy(_yNew.begin(), _yNew.end(), arg_y);
+        std::swap(_k[0], _k[6]);
+        _nSteps++;
+        const double step = std::fabs(h) * (err > 0. ? std::min(5., .9 * std::pow(err, -.2)) : 5.);
+        // A step cut short at arg_tEnd says nothing about a larger one.
+        if (!isLast || step < _step) {
+            _step = step;
+        }
+        if (++nSteps > maxSteps) {
+            _hasSlope = false;
+            return false;
+        }
+    }
+    return true;
+}
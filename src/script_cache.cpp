@@ -0,0 +1,309 @@
+/**
+ * @file script_cache.cpp
+ * @brief On-disk cache of compiled scripts
+ * @date Created on: 2026/10/17, 21:50
+ */
+
+#include "include/script_cache.h"
+#include "include/rg_data.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+
+namespace {
+
+    /**
+     * 64-bit FNV-1a hash of arg_str.
+     */
+    uint64_t fnv1a(const std::string& arg_str) {
+        uint64_t hash = 14695981039346656037ull;
+        for (const auto& c : arg_str) {
+            hash ^= (unsigned char) c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+}
+
+const char ScriptCache::magic[8] = {'E', 'L', 'V', 'A', 'S', 'C', 'S', 'C'};
+const uint32_t ScriptCache::version;
+
+void ScriptCache::_write(std::ostream& arg_os, const std::string& arg_str) {
+    _write(arg_os, uint32_t(arg_str.size()));
+    arg_os.write(arg_str.data(), arg_str.size());
+}
+
+void ScriptCache::_write(std::ostream& arg_os, const std::vector<std::string>& arg_strs) {
+    _write(arg_os, uint32_t(arg_strs.size()));
+    for (const auto& str : arg_strs) {
+        _write(arg_os, str);
+    }
+}
+
+void ScriptCache::_write(std::ostream& arg_os, const ASTReader::Program& arg_prog) {
+    _write(arg_os, uint32_t(arg_prog.code.size()));
+    for (const auto& inst : arg_prog.code) {
+        _write(arg_os, uint8_t(inst.op));
+        _write(arg_os, inst.dst);
+        _write(arg_os, inst.a);
+        _write(arg_os, inst.b);
+    }
+    _write(arg_os, uint32_t(arg_prog.numbers.size()));
+    for (const auto& num : arg_prog.numbers) {
+        _write(arg_os, num);
+    }
+    _write(arg_os, uint32_t(arg_prog.calls.size()));
+    for (const auto& site : arg_prog.calls) {
+        _write(arg_os, site.func);
+        _write(arg_os, uint64_t(site.argNum));
+    }
+    _write(arg_os, uint32_t(arg_prog.defs.size()));
+    for (const auto& def : arg_prog.defs) {
+        _write(arg_os, def.func);
+        _write(arg_os, uint64_t(def.argNum));
+        _write(arg_os, *def.body);
+    }
+    _write(arg_os, arg_prog.nRegs);
+    _write(arg_os, arg_prog.result);
+    _write(arg_os, arg_prog.line);
+}
+
+void ScriptCache::_read(std::istream& arg_is, std::string& arg_str) {
+    uint32_t size = 0;
+    _read(arg_is, size);
+    if (!arg_is || size > (1u << 24)) {
+        arg_is.setstate(std::ios::failbit);
+        return;
+    }
+    arg_str.resize(size);
+    arg_is.read(&arg_str[0], size);
+}
+
+void ScriptCache::_read(std::istream& arg_is, std::vector<std::string>& arg_strs) {
+    uint32_t size = 0;
+    _read(arg_is, size);
+    arg_strs.clear();
+    for (uint32_t i = 0; i < size && arg_is; i++) {
+        arg_strs.emplace_back();
+        _read(arg_is, arg_strs.back());
+    }
+}
+
+void ScriptCache::_read(std::istream& arg_is, ASTReader::Program& arg_prog, const int& arg_depth) {
+    // Sizes are checked against the bytes they need, so that a corrupt
+    // file fails instead of allocating without bound.
+    auto size = [&arg_is](const size_t& arg_unit) {
+        uint32_t size = 0;
+        _read(arg_is, size);
+        if (!arg_is || size > (1u << 30) / arg_unit) {
+            arg_is.setstate(std::ios::failbit);
+            return uint32_t(0);
+        }
+        return size;
+    };
+    if (arg_depth > 64) {
+        arg_is.setstate(std::ios::failbit);
+        return;
+    }
+    arg_prog.code.resize(size(13));
+    for (auto& inst : arg_prog.code) {
+        uint8_t op = 0;
+        _read(arg_is, op);
+        if (op > uint8_t(ASTReader::OpCode::Define)) {
+            arg_is.setstate(std::ios::failbit);
+        }
+        inst.op = ASTReader::OpCode(op);
+        _read(arg_is, inst.dst);
+        _read(arg_is, inst.a);
+        _read(arg_is, inst.b);
+    }
+    arg_prog.numbers.resize(size(8));
+    for (auto& num : arg_prog.numbers) {
+        _read(arg_is, num);
+    }
+    arg_prog.calls.resize(size(12));
+    for (auto& site : arg_prog.calls) {
+        uint64_t argNum = 0;
+        _read(arg_is, site.func);
+        _read(arg_is, argNum);
+        site.argNum = argNum;
+    }
+    arg_prog.defs.resize(size(12));
+    for (auto& def : arg_prog.defs) {
+        uint64_t argNum = 0;
+        _read(arg_is, def.func);
+        _read(arg_is, argNum);
+        def.argNum = argNum;
+        std::shared_ptr<ASTReader::Program> body = std::make_shared<ASTReader::Program>();
+        _read(arg_is, *body, arg_depth + 1);
+        def.body = body;
+    }
+    _read(arg_is, arg_prog.nRegs);
+    _read(arg_is, arg_prog.result);
+    _read(arg_is, arg_prog.line);
+}
+
+bool ScriptCache::_isValid(const ASTReader::Program& arg_prog, const size_t& arg_nVars, const size_t& arg_nFuncs) {
+    using ASTReader::OpCode;
+    const size_t nRegs = arg_prog.nRegs;
+    auto isReg = [nRegs](const int32_t& arg_reg) {
+        return arg_reg >= 0 && (size_t) arg_reg < nRegs;
+    };
+    auto isIndex = [](const int32_t& arg_index, const size_t& arg_size) {
+        return arg_index >= 0 && (size_t) arg_index < arg_size;
+    };
+    if (arg_prog.nRegs < 0 || (!arg_prog.code.empty() && !isReg(arg_prog.result))) {
+        return false;
+    }
+    for (const auto& inst : arg_prog.code) {
+        bool isValid = true;
+        switch (inst.op) {
+            case OpCode::LoadNum:
+                isValid = isReg(inst.dst) && isIndex(inst.a, arg_prog.numbers.size());
+                break;
+            case OpCode::LoadVar:
+            case OpCode::StoreVar:
+                isValid = isReg(inst.dst) && isIndex(inst.a, arg_nVars);
+                break;
+            case OpCode::Move:
+            case OpCode::Neg:
+            case OpCode::PowInt:
+            case OpCode::Truth:
+                isValid = isReg(inst.dst) && isReg(inst.a);
+                break;
+            case OpCode::Jump:
+                isValid = inst.dst >= 0 && (size_t) inst.dst <= arg_prog.code.size();
+                break;
+            case OpCode::JumpIfFalse:
+            case OpCode::JumpIfTrue:
+                isValid = inst.dst >= 0 && (size_t) inst.dst <= arg_prog.code.size() && isReg(inst.a);
+                break;
+            case OpCode::Call:
+                isValid = isReg(inst.dst) && isIndex(inst.b, arg_prog.calls.size());
+                if (isValid) {
+                    const ASTReader::CallSite& site = arg_prog.calls[inst.b];
+                    isValid = isIndex(site.func, arg_nFuncs) && inst.a >= 0 && site.argNum <= nRegs && (size_t) inst.a <= nRegs - site.argNum;
+                }
+                break;
+            case OpCode::Define:
+                isValid = isReg(inst.dst) && isIndex(inst.a, arg_prog.defs.size());
+                break;
+            default:
+                isValid = isReg(inst.dst) && isReg(inst.a) && isReg(inst.b);
+                break;
+        }
+        if (!isValid) {
+            return false;
+        }
+    }
+    for (const auto& def : arg_prog.defs) {
+        if (!isIndex(def.func, arg_nFuncs) || def.argNum > (size_t) def.body->nRegs || !_isValid(*def.body, arg_nVars, arg_nFuncs)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string ScriptCache::key(const std::string& arg_text) {
+    char buf[17];
+    std::snprintf(buf, sizeof (buf), "%016llx", (unsigned long long) fnv1a(arg_text));
+    return buf;
+}
+
+bool ScriptCache::read(const std::string& arg_path, const std::string& arg_text) {
+    if (!RGData::isLittleEndian()) {
+        return false;
+    }
+    std::ifstream ifs(arg_path, std::ios::binary);
+    char head[8];
+    uint32_t fileVersion = 0;
+    uint64_t checksum = 0;
+    ifs.read(head, 8);
+    _read(ifs, fileVersion);
+    if (!ifs || std::memcmp(head, magic, 8) != 0 || fileVersion != version) {
+        return false;
+    }
+    _read(ifs, checksum);
+    const std::string body((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    if (fnv1a(body) != checksum) {
+        throw ScriptCacheError("Script cache: " + arg_path + " is corrupt.");
+    }
+
+    std::istringstream is(body);
+    std::string text;
+    _read(is, text);
+    if (!is) {
+        throw ScriptCacheError("Script cache: " + arg_path + " is corrupt.");
+    }
+    if (text != arg_text) {
+        return false;
+    }
+    _read(is, vars);
+    _read(is, funcs);
+    uint32_t nActions = 0;
+    _read(is, nActions);
+    actions.clear();
+    for (uint32_t i = 0; i < nActions && is; i++) {
+        Action action;
+        _read(is, action.type);
+        _read(is, action.section);
+        _read(is, action.line);
+        _read(is, action.name);
+        _read(is, action.text);
+        _read(is, action.list);
+        _read(is, action.prog);
+        if (!action.type || !std::strchr("HGLITPR", action.type) || !action.section || !std::strchr("NGIBMEF", action.section)
+                || !_isValid(action.prog, vars.size(), funcs.size())) {
+            is.setstate(std::ios::failbit);
+        }
+        actions.emplace_back(std::move(action));
+    }
+    if (!is || is.peek() != std::istringstream::traits_type::eof()) {
+        throw ScriptCacheError("Script cache: " + arg_path + " is corrupt.");
+    }
+    return true;
+}
+
+void ScriptCache::write(const std::string& arg_path, const std::string& arg_text) const {
+    if (!RGData::isLittleEndian()) {
+        return;
+    }
+    std::ostringstream os;
+    _write(os, arg_text);
+    _write(os, vars);
+    _write(os, funcs);
+    _write(os, uint32_t(actions.size()));
+    for (const auto& action : actions) {
+        _write(os, action.type);
+        _write(os, action.section);
+        _write(os, action.line);
+        _write(os, action.name);
+        _write(os, action.text);
+        _write(os, action.list);
+        _write(os, action.prog);
+    }
+    const std::string body = os.str();
+
+    std::string temp = arg_path + "." + std::to_string(std::random_device()()) + ".tmp";
+    {
+        std::ofstream ofs(temp, std::ios::binary);
+        if (!ofs) {
+            return;
+        }
+        ofs.write(magic, 8);
+        _write(ofs, version);
+        _write(ofs, fnv1a(body));
+        ofs.write(body.data(), body.size());
+        if (!ofs) {
+            ofs.close();
+            std::remove(temp.c_str());
+            return;
+        }
+    }
+    if (std::rename(temp.c_str(), arg_path.c_str()) != 0) {
+        std::remove(temp.c_str());
+    }
+}
@@ -0,0 +1,42 @@
+/**
+ * @file thread_pool.cpp
+ * @brief Fixed-size pool of worker threads
+ * @date Created on: 2026/10/17, 16:40
+ */
+
+#include "include/thread_pool.h"
+
+ThreadPool::ThreadPool(size_t arg_size) : _stop(false) {
+    for (size_t i = 0; i < arg_size; i++) {
+        _threads.emplace_back(&ThreadPool::_run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cond.notify_all();
+    for (auto& thread : _threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::_run(size_t arg_id) {
+    while (true) {
+        std::function<void(size_t)> job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cond.wait(lock, [this] {
+                return _stop || !_jobs.empty();
+            });
+            if (_jobs.empty()) {
+                return;
+            }
+            job = std::move(_jobs.front());
+            _jobs.pop();
+        }
+        job(arg_id);
+    }
+}